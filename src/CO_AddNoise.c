@@ -9,6 +9,7 @@
 #include "histcounts.h"
 #include "stats.h"
 #include "CO_HistogramAMI.h"
+#include "feature_context.h"
 
 /*double gaussrand(MTRand* rand)
 {
@@ -53,64 +54,192 @@ double gaussrand(MTRand* rand)
 	return Z;
 }*/
 
-double CO_AddNoise_1_even_10_ami_at_10(const double y[], const int size) {
-
-    // check NAN
-    int i, j;
-    for (i = 0; i < size; i++)
-        if (isnan(y[i]))
-            return NAN;
+// Fixed-seed Gaussian noise. The generator is reseeded identically on every
+// call, so the noise for a series of length n is the first n draws of one
+// stream and a longer vector serves all shorter series. The longest vector
+// drawn so far is kept and shared between threads; it is replaced when a
+// longer series comes along and freed by its last user.
+typedef struct addnoise_noise {
+    int size;
+    double * values;
+    int refs;
+    int cached;
+} addnoise_noise;
+
+static addnoise_noise * noiseCache = NULL;
+
+static addnoise_noise * addnoise_noise_create(const int size)
+{
+    addnoise_noise * noise = malloc(sizeof(addnoise_noise));
+    noise->size = size;
+    noise->values = malloc(size * sizeof(double));
+    noise->refs = 0;
+    noise->cached = 0;
+
+    // generator type and seed are fixed, so skip gsl_rng_env_setup (which
+    // writes GSL globals and is not safe to call from several threads)
+    gsl_rng * rr = gsl_rng_alloc(gsl_rng_mt19937);
+    gsl_rng_set(rr, 0);
+    for (int i = 0; i < size; i++)
+        noise->values[i] = gsl_ran_gaussian_ziggurat(rr, 1.0);
+    gsl_rng_free(rr);
+
+    return noise;
+}
 
-    double *noise = (double*) malloc(size * sizeof(double));
-    double *yn = (double*) malloc(size * sizeof(double));
+static void addnoise_noise_free(addnoise_noise * noise)
+{
+    if (noise == NULL)
+        return;
+    free(noise->values);
+    free(noise);
+}
 
-    gsl_rng * rr;
-    double mu = 1.0;
-
-    gsl_rng_env_setup();
-    rr = gsl_rng_alloc (gsl_rng_mt19937);
-    //struct timeval tv; // Seed generation based on time
-    //gettimeofday(&tv,0);
-    //unsigned long seed = iter;//tv.tv_sec + tv.tv_usec;
-    long seed = 0;
-    gsl_rng_set(rr, seed);
-    
-    // twister random generator
-    //printf("noise is:\n");
-    for (i = 0; i < size; i++)
-        noise[i] = gsl_ran_gaussian_ziggurat(rr, mu);
-
-    int numRepeats = 50;
-    double *noiseRange = (double*) malloc(numRepeats * sizeof(double));
-    linspace(0, 3, numRepeats, noiseRange);
-    
-
-    double *amis = (double*) malloc(numRepeats * sizeof(double));
-    memset(amis, 0, numRepeats * sizeof(double));
-
-    for (i = 0; i < numRepeats; i++) {
-        for (j = 0; j < size; j++)
-            yn[j] = y[j] + (noiseRange[i] * noise[j]);
-
-        amis[i] = CO_HistogramAMI_even_10_1(yn, size);
-        if (isnan(amis[i])) {
-            printf("Error computing AMI: Time series too short (?)");
-            return NAN;
+// noise vector of at least size entries; pair with addnoise_noise_release
+static addnoise_noise * addnoise_noise_acquire(const int size)
+{
+    addnoise_noise * noise = NULL;
+
+#ifdef _OPENMP
+    #pragma omp critical(addnoise_noise_cache)
+#endif
+    {
+        if (noiseCache != NULL && noiseCache->size >= size) {
+            noise = noiseCache;
+            noise->refs++;
         }
     }
-    
-    double out = 0;
-    for (i = 0; i < numRepeats; i++) {
-        if (noiseRange[i] >= 1) { // noiseLevel = 1
-            out = amis[i];
-            break;
+    if (noise != NULL)
+        return noise;
+
+    // draw outside the lock
+    addnoise_noise * fresh = addnoise_noise_create(size);
+    addnoise_noise * evicted = NULL;
+
+#ifdef _OPENMP
+    #pragma omp critical(addnoise_noise_cache)
+#endif
+    {
+        // another thread may have drawn a long enough vector meanwhile
+        if (noiseCache != NULL && noiseCache->size >= size) {
+            noise = noiseCache;
         }
+        else {
+            if (noiseCache != NULL) {
+                noiseCache->cached = 0;
+                if (noiseCache->refs == 0)
+                    evicted = noiseCache;
+            }
+            fresh->cached = 1;
+            noiseCache = fresh;
+            noise = fresh;
+            fresh = NULL;
+        }
+        noise->refs++;
     }
 
-    free(noise);
-    free(noiseRange);
-    free(amis);
+    addnoise_noise_free(fresh);
+    addnoise_noise_free(evicted);
+    return noise;
+}
+
+static void addnoise_noise_release(addnoise_noise * noise)
+{
+    int drop = 0;
+
+#ifdef _OPENMP
+    #pragma omp critical(addnoise_noise_cache)
+#endif
+    {
+        noise->refs--;
+        drop = (noise->refs == 0 && !noise->cached);
+    }
+
+    // replaced while in use: the last user frees it
+    if (drop)
+        addnoise_noise_free(noise);
+}
+
+// AMI (10 bins, lag 1) of the series with noiseLevel times the noise added
+static double addnoise_ami(const double y[], const int size, const double noise[], const double noiseLevel, double yn[])
+{
+    for (int j = 0; j < size; j++)
+        yn[j] = y[j] + (noiseLevel * noise[j]);
+
+    feature_context nctx;
+    context_init(&nctx, yn, size, 0);
+    double ami = CO_HistogramAMI_even_ctx(&nctx, 10, 1);
+    context_free(&nctx);
+
+    return ami;
+}
+
+void CO_AddNoise_1_even_10_ami_curve_ctx(feature_context * ctx, double amis[CO_ADDNOISE_NUM_LEVELS])
+{
+    int i;
+    if (context_has_nan(ctx)) {
+        for (i = 0; i < CO_ADDNOISE_NUM_LEVELS; i++)
+            amis[i] = NAN;
+        return;
+    }
+
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
+
+    double noiseRange[CO_ADDNOISE_NUM_LEVELS];
+    linspace(0, 3, CO_ADDNOISE_NUM_LEVELS, noiseRange);
+
+    addnoise_noise * noise = addnoise_noise_acquire(size);
+    double *yn = (double*) malloc(size * sizeof(double));
+
+    for (i = 0; i < CO_ADDNOISE_NUM_LEVELS; i++)
+        amis[i] = addnoise_ami(y, size, noise->values, noiseRange[i], yn);
+
     free(yn);
+    addnoise_noise_release(noise);
+}
+
+void CO_AddNoise_1_even_10_ami_curve(const double y[], const int size, double amis[CO_ADDNOISE_NUM_LEVELS])
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    CO_AddNoise_1_even_10_ami_curve_ctx(&ctx, amis);
+    context_free(&ctx);
+}
+
+double CO_AddNoise_1_even_10_ami_at_10_ctx(feature_context * ctx) {
 
+    // check NAN
+    if (context_has_nan(ctx))
+        return NAN;
+
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
+
+    // only the first noise level >= 1 (noiseLevel = 1) is reported, so
+    // that is the only one evaluated
+    double noiseRange[CO_ADDNOISE_NUM_LEVELS];
+    linspace(0, 3, CO_ADDNOISE_NUM_LEVELS, noiseRange);
+    int level = 0;
+    while (level < CO_ADDNOISE_NUM_LEVELS - 1 && noiseRange[level] < 1)
+        level++;
+
+    addnoise_noise * noise = addnoise_noise_acquire(size);
+    double *yn = (double*) malloc(size * sizeof(double));
+
+    double out = addnoise_ami(y, size, noise->values, noiseRange[level], yn);
+
+    free(yn);
+    addnoise_noise_release(noise);
+
+    // NaN if the series is too short for the AMI
+    return out;
+}
+
+double CO_AddNoise_1_even_10_ami_at_10(const double y[], const int size) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = CO_AddNoise_1_even_10_ami_at_10_ctx(&ctx);
+    context_free(&ctx);
     return out;
 }
@@ -3,6 +3,16 @@
 
 #define PI 3.141592654
 
+// noise levels linspace(0, 3, CO_ADDNOISE_NUM_LEVELS) in units of the noise std
+#define CO_ADDNOISE_NUM_LEVELS 50
+
+#include "feature_context.h"
+
 extern double CO_AddNoise_1_even_10_ami_at_10(const double y[], const int size);
+extern double CO_AddNoise_1_even_10_ami_at_10_ctx(feature_context * ctx);
+// AMI (10 even bins, lag 1) at every noise level, of which
+// CO_AddNoise_1_even_10_ami_at_10 is the first level >= 1
+extern void CO_AddNoise_1_even_10_ami_curve(const double y[], const int size, double amis[CO_ADDNOISE_NUM_LEVELS]);
+extern void CO_AddNoise_1_even_10_ami_curve_ctx(feature_context * ctx, double amis[CO_ADDNOISE_NUM_LEVELS]);
 
 #endif
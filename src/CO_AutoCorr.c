@@ -18,6 +18,9 @@ typedef _Dcomplex cplx;
 #include "stats.h"
 #include "fft.h"
 #include "histcounts.h"
+#include "feature_context.h"
+#include "CO_AutoCorr.h"
+#include "CO_HistogramAMI.h"
 
 #include "helper_functions.h"
 
@@ -63,155 +66,213 @@ void dot_multiply(cplx a[], cplx b[], int size)
     }
 }
 
-double * CO_AutoCorr(const double y[], const int size, const int tau[], const int tau_size)
+// circular lagged product sums sum_i x[i] x[i + lag] of count series of
+// equal length, zero padded to nFFT >= 2 * size - 1 so that lags < size are
+// linear. With demean the series mean is removed first. The series are
+// transformed together in interleaved layout; out[j] receives nFFT lags of
+// series j.
+static void lag_products_fft_batch(const double * const ys[], const int count, const int size, const int nFFT, const int demean, double * out[])
 {
-    double m, nFFT;
-    m = mean(y, size);
-    nFFT = nextpow2(size) << 1;
+    fft_plan * plan = fft_plan_acquire(nFFT);
+    double * x = malloc(nFFT * count * sizeof(double));
+    double * re = malloc((nFFT / 2 + 1) * count * sizeof(double));
+    double * im = malloc((nFFT / 2 + 1) * count * sizeof(double));
+
+    for (int j = 0; j < count; j++) {
+        double m = demean ? mean(ys[j], size) : 0.0;
+        for (int i = 0; i < size; i++) {
+            x[i * count + j] = ys[j][i] - m;
+        }
+    }
+    for (int i = size * count; i < nFFT * count; i++) {
+        x[i] = 0.0;
+    }
 
-    cplx * F = malloc(nFFT * sizeof *F);
-    cplx * tw = malloc(nFFT * sizeof *tw);
-    for (int i = 0; i < size; i++) {
-        
-        #if defined(__GNUC__) || defined(__GNUG__)
-                F[i] = CMPLX(y[i] - m, 0.0);
-        #elif defined(_MSC_VER)
-                cplx tmp = { y[i] - m, 0.0 };
-                F[i] = tmp;
-        #endif
-        
+    // power spectrum, then back to the time domain
+    rfft_batch(plan, count, x, re, im);
+    for (int i = 0; i < (nFFT / 2 + 1) * count; i++) {
+        re[i] = re[i] * re[i] + im[i] * im[i];
+        im[i] = 0.0;
     }
-    for (int i = size; i < nFFT; i++) {
-        #if defined(__GNUC__) || defined(__GNUG__)
-                F[i] = CMPLX(0.0, 0.0);
-        #elif defined(_MSC_VER)
-                cplx tmp = { 0.0, 0.0 };
-                F[i] = tmp; // CMPLX(0.0, 0.0);
-        #endif
-        
+    irfft_batch(plan, count, re, im, x);
+
+    for (int j = 0; j < count; j++) {
+        for (int i = 0; i < nFFT; i++) {
+            out[j][i] = x[i * count + j];
+        }
     }
-    // size = nFFT;
 
-    twiddles(tw, nFFT);
-    fft(F, nFFT, tw);
-    dot_multiply(F, F, nFFT);
-    fft(F, nFFT, tw);
-    cplx divisor = F[0];
-    for (int i = 0; i < nFFT; i++) {
-        //F[i] = F[i] / divisor;
-        F[i] = _Cdivcc(F[i], divisor);
+    free(x);
+    free(re);
+    free(im);
+    fft_plan_release(plan);
+}
+
+// normalised autocorrelations of count mean-removed series of equal length
+static void autocorr_fft_batch(const double * const ys[], const int count, const int size, const int nFFT, double * out[])
+{
+    lag_products_fft_batch(ys, count, size, nFFT, 1, out);
+    for (int j = 0; j < count; j++) {
+        double divisor = out[j][0];
+        for (int i = 0; i < nFFT; i++) {
+            out[j][i] = out[j][i] / divisor;
+        }
     }
-    
-    double * out = malloc(tau_size * sizeof(out));
+}
+
+static double * autocorr_fft(const double y[], const int size, const int nFFT)
+{
+    double * out = malloc(nFFT * sizeof(double));
+    autocorr_fft_batch(&y, 1, size, nFFT, &out);
+    return out;
+}
+
+double * CO_AutoCorr(const double y[], const int size, const int tau[], const int tau_size)
+{
+    // small lags by direct sums, anything further through the FFT
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+
+    double * out = malloc(tau_size * sizeof(double));
     for (int i = 0; i < tau_size; i++) {
-        out[i] = creal(F[tau[i]]);
+        out[i] = context_acf(&ctx, tau[i]);
     }
-    free(F);
-    free(tw);
+    context_free(&ctx);
     return out;
 }
 
 double * co_autocorrs(const double y[], const int size)
 {
-    double m, nFFT;
-    m = mean(y, size);
-    nFFT = nextpow2(size) << 1;
-    
-    cplx * F = malloc(nFFT * 2 * sizeof *F);
-    cplx * tw = malloc(nFFT * 2 * sizeof *tw);
-    for (int i = 0; i < size; i++) {
-        
-        #if defined(__GNUC__) || defined(__GNUG__)
-                F[i] = CMPLX(y[i] - m, 0.0);
-        #elif defined(_MSC_VER)
-                cplx tmp = { y[i] - m, 0.0 };
-                F[i] = tmp;
-        #endif
-    }
-    for (int i = size; i < nFFT; i++) {
-        
-        #if defined(__GNUC__) || defined(__GNUG__)
-            F[i] = CMPLX(0.0, 0.0);
-        #elif defined(_MSC_VER)
-            cplx tmp = { 0.0, 0.0 };
-            F[i] = tmp;
-        #endif
-    }
-    //size = nFFT;
-    
-    twiddles(tw, nFFT);
-    fft(F, nFFT, tw);
-    dot_multiply(F, F, nFFT);
-    fft(F, nFFT, tw);
-    cplx divisor = F[0];
-    for (int i = 0; i < nFFT; i++) {
-        F[i] = _Cdivcc(F[i], divisor); // F[i] / divisor;
-    }
-    
-    double * out = malloc(nFFT * 2 * sizeof(out));
-    for (int i = 0; i < nFFT; i++) {
-        out[i] = creal(F[i]);
-    }
-    free(F);
-    free(tw);
+    int nFFT = fft_next_size(2 * size - 1);
+    return autocorr_fft(y, size, nFFT);
+}
+
+void co_autocorrs_batch(const double * const ys[], const int count, const int size, double * out[])
+{
+    int nFFT = fft_next_size(2 * size - 1);
+    for (int j = 0; j < count; j++) {
+        out[j] = malloc(nFFT * sizeof(double));
+    }
+    autocorr_fft_batch(ys, count, size, nFFT, out);
+}
+
+// lagged product sums sum_i x[i] x[i + lag] of a mean-removed series x for
+// lags firstLag .. firstLag + nLags - 1 (nLags <= CO_LAG_BLOCK), accumulated
+// in one pass over the data so all lags of a block share the loads
+void co_lag_products(const double x[], const int size, const int firstLag, const int nLags, double out[])
+{
+    double acc[CO_LAG_BLOCK] = {0};
+
+    // full blocks while every lag still overlaps
+    int full = size - (firstLag + nLags - 1);
+    int i = 0;
+    if (nLags == CO_LAG_BLOCK) {
+        for (; i < full; i++) {
+            const double xi = x[i];
+            const double * xl = x + i + firstLag;
+            for (int b = 0; b < CO_LAG_BLOCK; b++) {
+                acc[b] += xi * xl[b];
+            }
+        }
+    }
+    else {
+        for (; i < full; i++) {
+            const double xi = x[i];
+            const double * xl = x + i + firstLag;
+            for (int b = 0; b < nLags; b++) {
+                acc[b] += xi * xl[b];
+            }
+        }
+    }
+    // tail, where the larger lags run out of samples
+    for (; i < size - firstLag; i++) {
+        for (int b = 0; b < nLags && i + firstLag + b < size; b++) {
+            acc[b] += x[i] * x[i + firstLag + b];
+        }
+    }
+
+    for (int b = 0; b < nLags; b++) {
+        out[b] = acc[b];
+    }
+}
+
+// autocov_lag(y, size, lag) for all lags 0..maxlag in O(size log size):
+// lagged products of the raw series, each divided by the number of
+// overlapping samples (NaN for lags without overlap)
+double * co_autocov_lags(const double y[], const int size, const int maxlag)
+{
+    int nFFT = fft_next_size(2 * size - 1);
+    double * products = malloc(nFFT * sizeof(double));
+    lag_products_fft_batch(&y, 1, size, nFFT, 0, &products);
+
+    double * out = malloc((maxlag + 1) * sizeof(double));
+    for (int lag = 0; lag <= maxlag; lag++) {
+        out[lag] = lag < size ? products[lag] / (size - lag) : NAN;
+    }
+    free(products);
     return out;
 }
 
-int co_firstzero(const double y[], const int size, const int maxtau)
+int co_firstzero_acf(const double autocorrs[], const int maxtau)
 {
-    
-    //double * autocorrs = malloc(size * sizeof * autocorrs);
-    //autocorrs = co_autocorrs(y, size);
-    
-    double * autocorrs = co_autocorrs(y, size);
-    
     int zerocrossind = 0;
     while(autocorrs[zerocrossind] > 0 && zerocrossind < maxtau)
     {
         zerocrossind += 1;
     }
     
-    free(autocorrs);
     return zerocrossind;
-    
 }
 
-int CO_f1ecac(const double y[], const int size)
+int co_firstzero(const double y[], const int size, const int maxtau)
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    int zerocrossind = context_firstzero_max(&ctx, maxtau);
+    context_free(&ctx);
+    return zerocrossind;
+}
+
+int CO_f1ecac_ctx(feature_context * ctx)
 {
     
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return 0;
-        }
+        return 0;
     }
     
-    // compute autocorrelations
-    double * autocorrs = co_autocorrs(y, size);
+    const int size = ctx->size;
     
-    // threshold to cross
+    // threshold to cross; autocorrelations are computed lag by lag until found
     double thresh = 1.0/exp(1);
     
     int out = size;
+    double acPrev = context_acf(ctx, 0);
     for(int i = 0; i < size-1; i++){
         
-        // printf("autocorrs_i: %1.3f autocorrs_i+1: %1.3f\n", autocorrs[i], autocorrs[i+1]);
+        double acNext = context_acf(ctx, i+1);
         
-        if ((autocorrs[i] - thresh)*(autocorrs[i+1] - thresh) < 0){
+        if ((acPrev - thresh)*(acNext - thresh) < 0){
             out = i + 1;
-            free(autocorrs);
             return out;
         }
+        acPrev = acNext;
     }
     
-    free(autocorrs);
-    
     return out;
     
 }
 
+int CO_f1ecac(const double y[], const int size)
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    int out = CO_f1ecac_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
+
 double CO_Embed2_Basic_tau_incircle(const double y[], const int size, const double radius, const int tau)
 {
     int tauIntern = 0;
@@ -236,19 +297,19 @@ double CO_Embed2_Basic_tau_incircle(const double y[], const int size, const doub
     return insidecount/(size-tauIntern);
 }
 
-double CO_Embed2_Dist_tau_d_expfit_meandiff(const double y[], const int size)
+double CO_Embed2_Dist_tau_d_expfit_meandiff_ctx(feature_context * ctx)
 {
     
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
+        return NAN;
     }
     
-    int tau = co_firstzero(y, size, size);
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
+    
+    int tau = context_firstzero(ctx);
     
     //printf("co_firstzero ran\n");
     
@@ -346,55 +407,74 @@ double CO_Embed2_Dist_tau_d_expfit_meandiff(const double y[], const int size)
     
 }
 
-int CO_FirstMin_ac(const double y[], const int size)
+double CO_Embed2_Dist_tau_d_expfit_meandiff(const double y[], const int size)
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = CO_Embed2_Dist_tau_d_expfit_meandiff_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
+
+int CO_FirstMin_ac_ctx(feature_context * ctx)
 {
     
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return 0;
-        }
+        return 0;
     }
     
-    double * autocorrs = co_autocorrs(y, size);
+    const int size = ctx->size;
     
+    // autocorrelations are computed lag by lag until the first minimum
     int minInd = size;
+    double acPrev = context_acf(ctx, 0);
+    double acCur = context_acf(ctx, 1);
     for(int i = 1; i < size-1; i++)
     {
-        if(autocorrs[i] < autocorrs[i-1] && autocorrs[i] < autocorrs[i+1])
+        double acNext = context_acf(ctx, i+1);
+        if(acCur < acPrev && acCur < acNext)
         {
             minInd = i;
             break;
         }
+        acPrev = acCur;
+        acCur = acNext;
     }
     
-    free(autocorrs);
-    
     return minInd;
     
 }
 
-double CO_trev_1_num(const double y[], const int size)
+int CO_FirstMin_ac(const double y[], const int size)
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    int out = CO_FirstMin_ac_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
+
+double CO_trev_1_num_ctx(feature_context * ctx)
 {
     
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
+        return NAN;
     }
     
+    const int size = ctx->size;
+    const double * yDiff = context_diff(ctx);
+    
     int tau = 1;
     
     double * diffTemp = malloc((size-1) * sizeof * diffTemp);
     
     for(int i = 0; i < size-tau; i++)
     {
-        diffTemp[i] = pow(y[i+1] - y[i],3);
+        diffTemp[i] = pow(yDiff[i],3);
     }
     
     double out;
@@ -406,157 +486,25 @@ double CO_trev_1_num(const double y[], const int size)
     return out;
 }
 
-#define tau 2
-#define numBins 5
-
-double CO_HistogramAMI_even_2_5(const double y[], const int size)
+double CO_trev_1_num(const double y[], const int size)
 {
-    
-    // NaN check
-    for(int i = 0; i < size; i++)
-    {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
-    }
-    
-    //const int tau = 2;
-    //const int numBins = 5;
-    
-    double * y1 = malloc((size-tau) * sizeof(double));
-    double * y2 = malloc((size-tau) * sizeof(double));
-    
-    for(int i = 0; i < size-tau; i++){
-        y1[i] = y[i];
-        y2[i] = y[i+tau];
-    }
-    
-    // set bin edges
-    const double maxValue = max_(y, size);
-    const double minValue = min_(y, size);
-    
-    double binStep = (maxValue - minValue + 0.2)/5;
-    //double binEdges[numBins+1] = {0};
-	double binEdges[5+1] = {0};
-    for(int i = 0; i < numBins+1; i++){
-        binEdges[i] = minValue + binStep*i - 0.1;
-        // printf("binEdges[%i] = %1.3f\n", i, binEdges[i]);
-    }
-    
-    
-    // count histogram bin contents
-    int * bins1;
-    bins1 = histbinassign(y1, size-tau, binEdges, numBins+1);
-    
-    int * bins2;
-    bins2 = histbinassign(y2, size-tau, binEdges, numBins+1);
-    
-    /*
-    // debug
-    for(int i = 0; i < size-tau; i++){
-        printf("bins1[%i] = %i, bins2[%i] = %i\n", i, bins1[i], i, bins2[i]);
-    }
-    */
-    
-    // joint
-    double * bins12 = malloc((size-tau) * sizeof(double));
-    //double binEdges12[(numBins + 1) * (numBins + 1)] = {0};
-	double binEdges12[(5 + 1) * (5 + 1)] = {0};    
-
-    for(int i = 0; i < size-tau; i++){
-        bins12[i] = (bins1[i]-1)*(numBins+1) + bins2[i];
-        // printf("bins12[%i] = %1.3f\n", i, bins12[i]);
-    }
-    
-    for(int i = 0; i < (numBins+1)*(numBins+1); i++){
-        binEdges12[i] = i+1;
-        // printf("binEdges12[%i] = %1.3f\n", i, binEdges12[i]);
-    }
-    
-    // fancy solution for joint histogram here
-    int * jointHistLinear;
-    jointHistLinear = histcount_edges(bins12, size-tau, binEdges12, (numBins + 1) * (numBins + 1));
-    
-    /*
-    // debug
-    for(int i = 0; i < (numBins+1)*(numBins+1); i++){
-        printf("jointHistLinear[%i] = %i\n", i, jointHistLinear[i]);
-    }
-    */
-    
-    // transfer to 2D histogram (no last bin, as in original implementation)
-    double pij[numBins][numBins];
-    int sumBins = 0;
-    for(int i = 0; i < numBins; i++){
-        for(int j = 0; j < numBins; j++){
-            pij[j][i] = jointHistLinear[i*(numBins+1)+j];
-            
-            // printf("pij[%i][%i]=%1.3f\n", i, j, pij[i][j]);
-            
-            sumBins += pij[j][i];
-        }
-    }
-    
-    // normalise
-    for(int i = 0; i < numBins; i++){
-        for(int j = 0; j < numBins; j++){
-            pij[j][i] /= sumBins;
-        }
-    }
-
-    // marginals
-    //double pi[numBins] = {0};
-	double pi[5] = {0};
-    //double pj[numBins] = {0};
-	double pj[5] = {0};
-    for(int i = 0; i < numBins; i++){
-        for(int j = 0; j < numBins; j++){
-            pi[i] += pij[i][j];
-            pj[j] += pij[i][j];
-            // printf("pij[%i][%i]=%1.3f, pi[%i]=%1.3f, pj[%i]=%1.3f\n", i, j, pij[i][j], i, pi[i], j, pj[j]);
-        }
-    }
-    
-    /*
-    // debug
-    for(int i = 0; i < numBins; i++){
-        printf("pi[%i]=%1.3f, pj[%i]=%1.3f\n", i, pi[i], i, pj[i]);
-    }
-    */
-    
-    // mutual information
-    double ami = 0;
-    for(int i = 0; i < numBins; i++){
-        for(int j = 0; j < numBins; j++){
-            if(pij[i][j] > 0){
-                //printf("pij[%i][%i]=%1.3f, pi[%i]=%1.3f, pj[%i]=%1.3f, logarg=, %1.3f, log(...)=%1.3f\n",
-                //       i, j, pij[i][j], i, pi[i], j, pj[j], pij[i][j]/(pi[i]*pj[j]), log(pij[i][j]/(pi[i]*pj[j])));
-                ami += pij[i][j] * log(pij[i][j]/(pj[j]*pi[i]));
-            }
-        }
-    }
-    
-    free(bins1);
-    free(bins2);
-    free(jointHistLinear);
-    
-    free(y1);
-    free(y2);
-    free(bins12);
-    
-    return ami;
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = CO_trev_1_num_ctx(&ctx);
+    context_free(&ctx);
+    return out;
 }
 
+double CO_HistogramAMI_even_2_5_ctx(feature_context * ctx)
+{
+    return CO_HistogramAMI_even_ctx(ctx, 5, 2);
+}
 
-
-
-
-
-
-
-
-
-
-
-
+double CO_HistogramAMI_even_2_5(const double y[], const int size)
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = CO_HistogramAMI_even_2_5_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
@@ -19,17 +19,30 @@ typedef _Dcomplex cplx;
 #include <stdlib.h>
 #include "stats.h"
 #include "fft.h"
+#include "feature_context.h"
+
+// number of lags accumulated together by co_lag_products
+#define CO_LAG_BLOCK 8
 
 extern int nextpow2(int n);
 extern void dot_multiply(cplx a[], cplx b[], int size);
 extern double * CO_AutoCorr(const double y[], const int size, const int tau[], const int tau_size);
 extern double * co_autocorrs(const double y[], const int size);
+extern void co_lag_products(const double x[], const int size, const int firstLag, const int nLags, double out[]);
+extern double * co_autocov_lags(const double y[], const int size, const int maxlag);
+extern void co_autocorrs_batch(const double * const ys[], const int count, const int size, double * out[]);
 extern int co_firstzero(const double y[], const int size, const int maxtau);
+extern int co_firstzero_acf(const double autocorrs[], const int maxtau);
 extern double CO_Embed2_Basic_tau_incircle(const double y[], const int size, const double radius, const int tau);
 extern double CO_Embed2_Dist_tau_d_expfit_meandiff(const double y[], const int size);
+extern double CO_Embed2_Dist_tau_d_expfit_meandiff_ctx(feature_context * ctx);
 extern int CO_FirstMin_ac(const double y[], const int size);
+extern int CO_FirstMin_ac_ctx(feature_context * ctx);
 extern double CO_trev_1_num(const double y[], const int size);
+extern double CO_trev_1_num_ctx(feature_context * ctx);
 extern int CO_f1ecac(const double y[], const int size);
+extern int CO_f1ecac_ctx(feature_context * ctx);
 extern double CO_HistogramAMI_even_2_5(const double y[], const int size);
+extern double CO_HistogramAMI_even_2_5_ctx(feature_context * ctx);
 
 #endif
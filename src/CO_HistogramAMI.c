@@ -2,152 +2,166 @@
 #include "histcounts.h"
 #include "helper_functions.h"
 #include "stats.h"
+#include "feature_context.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
 
-//#define tau 1 // before = 3
-//#define numBins 10 // before = 2
-
-double CO_HistogramAMI_even(const double y[], const int size, const int numBins, const int tau) {
-    
-    // NaN check
-    for (int i = 0; i < size; i++)
-        if (isnan(y[i]))
-            return NAN;
-    
-    //int tau = 1;
-    //int numBins = 10;
-    
-    double * y1 = malloc((size-tau) * sizeof(double));
-    double * y2 = malloc((size-tau) * sizeof(double));
-    
-    for (int i = 0; i < size-tau; i++) {
-        y1[i] = y[i];
-        y2[i] = y[i+tau];
-    }
+// bin label of every sample for numBins even bins spanning the series
+// (padded by 0.1 on either side), as histbinassign gives them
+static void ami_bin_labels(feature_context * ctx, const int numBins, int labels[])
+{
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
     
     // set bin edges
-    const double maxValue = max_(y, size);
-    const double minValue = min_(y, size);
+    const double maxValue = context_max(ctx);
+    const double minValue = context_min(ctx);
     
     double binStep = (maxValue - minValue + 0.2)/numBins; // problem
-    //double binEdges[numBins+1] = {0};
-	//double binEdges[10+1] = {0};
     double *binEdges = (double*) malloc((numBins+1) * sizeof(double));
-    memset(binEdges, 0, (numBins+1)*sizeof(double));
     for (int i = 0; i < numBins+1; i++) {
         binEdges[i] = minValue + binStep*i - 0.1;
-        //printf("binEdges[%i] = %1.3f\n", i, binEdges[i]);
-    }
-    
-    
-    // count histogram bin contents
-    int * bins1;
-    bins1 = histbinassign(y1, size-tau, binEdges, numBins+1);
-    
-    int * bins2;
-    bins2 = histbinassign(y2, size-tau, binEdges, numBins+1);
-    
-    /*
-    // debug
-    for(int i = 0; i < size-tau; i++){
-        printf("bins1[%i] = %i, bins2[%i] = %i\n", i, bins1[i], i, bins2[i]);
     }
-    */
     
-    // joint
-    double *bins12 = (double*) malloc((size-tau) * sizeof(double));
-    //double binEdges12[(numBins + 1) * (numBins + 1)] = {0};
-	//double binEdges12[(10 + 1) * (10 + 1)] = {0};
-    double *binEdges12 = (double*) malloc(((numBins+1) * (numBins+1)) * sizeof(double));
-    memset(binEdges12, 0, ((numBins+1) * (numBins+1))*sizeof(double));
+    histbinassign_preallocated(y, size, binEdges, numBins+1, labels);
     
-    for (int i = 0; i < size-tau; i++) {
-        bins12[i] = (bins1[i]-1)*(numBins+1) + bins2[i];
-        // printf("bins12[%i] = %1.3f\n", i, bins12[i]);
-    }
-    for (int i = 0; i < (numBins+1)*(numBins+1); i++) {
-        binEdges12[i] = i+1;
-        // printf("binEdges12[%i] = %1.3f\n", i, binEdges12[i]);
+    free(binEdges);
+}
+
+// Labels for numBins, from the context if one of its slots holds them. A
+// new labelling takes a free slot if there is one; otherwise the caller gets
+// its own copy (*owned set) and has to free it.
+static const int * context_ami_labels(feature_context * ctx, const int numBins, int * owned)
+{
+    *owned = 0;
+    for (int k = 0; k < CONTEXT_AMI_LABEL_SLOTS; k++) {
+        if (ctx->amiLabelBins[k] == numBins) {
+            return ctx->amiLabels[k];
+        }
     }
-    
-    // fancy solution for joint histogram here
-    int * jointHistLinear;
-    jointHistLinear = histcount_edges(bins12, size-tau, binEdges12, (numBins + 1) * (numBins + 1));
-    
-    /*
-    // debug
-    for(int i = 0; i < (numBins+1)*(numBins+1); i++){
-        printf("jointHistLinear[%i] = %i\n", i, jointHistLinear[i]);
+    int * labels = malloc(ctx->size * sizeof(int));
+    ami_bin_labels(ctx, numBins, labels);
+    for (int k = 0; k < CONTEXT_AMI_LABEL_SLOTS; k++) {
+        if (ctx->amiLabelBins[k] == 0) {
+            ctx->amiLabelBins[k] = numBins;
+            ctx->amiLabels[k] = labels;
+            return labels;
+        }
     }
-    */
-    
+    *owned = 1;
+    return labels;
+}
+
+// automutual information from the joint histogram of labels at t and t+tau;
+// pij holds numBins*numBins doubles, pi and pj numBins each
+static double ami_from_joint(const int jointHistLinear[], const int numBins, double pij[], double pi[], double pj[])
+{
     // transfer to 2D histogram (no last bin, as in original implementation)
-    double pij[numBins][numBins];
     int sumBins = 0;
     for (int i = 0; i < numBins; i++) {
         for (int j = 0; j < numBins; j++) {
-            pij[j][i] = jointHistLinear[i*(numBins+1)+j];
-            
-            // printf("pij[%i][%i]=%1.3f\n", i, j, pij[i][j]);
-            
-            sumBins += pij[j][i];
+            pij[j*numBins+i] = jointHistLinear[i*(numBins+1)+j];
+            sumBins += pij[j*numBins+i];
         }
     }
     
     // normalise
     for (int i = 0; i < numBins; i++)
         for (int j = 0; j < numBins; j++)
-            pij[j][i] /= sumBins;
+            pij[j*numBins+i] /= sumBins;
 
     // marginals
-    //double pi[numBins] = {0};
-	//double pi[10] = {0};
-    double *pi = (double*) malloc(numBins * sizeof(double));
     memset(pi, 0, numBins*sizeof(double));
-    //double pj[numBins] = {0};
-	//double pj[10] = {0};
-    double *pj = (double*) malloc(numBins * sizeof(double));
     memset(pj, 0, numBins*sizeof(double));
     for (int i = 0; i < numBins; i++) {
         for (int j = 0; j < numBins; j++) {
-            pi[i] += pij[i][j];
-            pj[j] += pij[i][j];
-            //printf("pij[%i][%i]=%1.3f, pi[%i]=%1.3f, pj[%i]=%1.3f\n", i, j, pij[i][j], i, pi[i], j, pj[j]);
+            pi[i] += pij[i*numBins+j];
+            pj[j] += pij[i*numBins+j];
         }
     }
     
-    /*
-    // debug
-    for(int i = 0; i < numBins; i++){
-        printf("pi[%i]=%1.3f, pj[%i]=%1.3f\n", i, pi[i], i, pj[i]);
-    }
-    */
     // mutual information
     double ami = 0;
     for (int i = 0; i < numBins; i++) {
         for (int j = 0; j < numBins; j++) {
-            if (pij[i][j] > 0) {
-                //printf("I m in %lf\n", pij[i][j]);
-                //printf("pij[%i][%i]=%1.3f, pi[%i]=%1.3f, pj[%i]=%1.3f, logarg=, %1.3f, log(...)=%1.3f\n",
-                //       i, j, pij[i][j], i, pi[i], j, pj[j], pij[i][j]/(pi[i]*pj[j]), log(pij[i][j]/(pi[i]*pj[j])));
-                ami += pij[i][j] * log(pij[i][j]/(pj[j]*pi[i]));
+            if (pij[i*numBins+j] > 0) {
+                ami += pij[i*numBins+j] * log(pij[i*numBins+j]/(pj[j]*pi[i]));
             }
         }
     }
     
-    free(bins1);
-    free(bins2);
-    free(jointHistLinear);
+    return ami;
+}
+
+void CO_HistogramAMI_even_multi_ctx(feature_context * ctx, const int numBins[], const int tau[], const int n, double out[])
+{
+    // NaN check
+    if (context_has_nan(ctx)) {
+        for (int k = 0; k < n; k++)
+            out[k] = NAN;
+        return;
+    }
     
-    free(y1);
-    free(y2);
-    free(bins12);
+    const int size = ctx->size;
+    
+    // largest joint histogram needed
+    int maxBins = 0;
+    for (int k = 0; k < n; k++)
+        if (numBins[k] > maxBins && numBins[k] <= CO_HISTOGRAMAMI_MAX_BINS)
+            maxBins = numBins[k];
+    const size_t maxBins1 = (size_t)maxBins + 1;
+    int * jointHistLinear = malloc(maxBins1 * maxBins1 * sizeof(int));
+    double * pij = malloc(maxBins1 * maxBins1 * sizeof(double));
+    double * pi = malloc(maxBins1 * sizeof(double));
+    double * pj = malloc(maxBins1 * sizeof(double));
+    
+    for (int k = 0; k < n; k++) {
+        if (numBins[k] < 1 || numBins[k] > CO_HISTOGRAMAMI_MAX_BINS || tau[k] < 0 || tau[k] >= size) {
+            out[k] = NAN;
+            continue;
+        }
+        
+        // one labelling per bin count; the pairs (t, t+tau) are the
+        // label array against itself shifted by tau
+        int owned;
+        const int * labels = context_ami_labels(ctx, numBins[k], &owned);
+        
+        histjointcounts(labels, labels + tau[k], size-tau[k], numBins[k]+1, jointHistLinear);
+        out[k] = ami_from_joint(jointHistLinear, numBins[k], pij, pi, pj);
+        
+        if (owned)
+            free((int *)labels);
+    }
     
-    return ami;
+    free(jointHistLinear);
+    free(pij);
+    free(pi);
+    free(pj);
+}
+
+void CO_HistogramAMI_even_multi(const double y[], const int size, const int numBins[], const int tau[], const int n, double out[])
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    CO_HistogramAMI_even_multi_ctx(&ctx, numBins, tau, n, out);
+    context_free(&ctx);
+}
+
+double CO_HistogramAMI_even_ctx(feature_context * ctx, const int numBins, const int tau) {
+    double out;
+    CO_HistogramAMI_even_multi_ctx(ctx, &numBins, &tau, 1, &out);
+    return out;
+}
+
+double CO_HistogramAMI_even(const double y[], const int size, const int numBins, const int tau) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = CO_HistogramAMI_even_ctx(&ctx, numBins, tau);
+    context_free(&ctx);
+    return out;
 }
 
 double CO_HistogramAMI_even_10_1(const double y[], const int size) {
@@ -161,3 +175,15 @@ double CO_HistogramAMI_even_10_3(const double y[], const int size) {
 double CO_HistogramAMI_even_2_3(const double y[], const int size) {
     return CO_HistogramAMI_even(y, size, 2, 3);
 }
+
+double CO_HistogramAMI_even_10_1_ctx(feature_context * ctx) {
+    return CO_HistogramAMI_even_ctx(ctx, 10, 1);
+}
+
+double CO_HistogramAMI_even_10_3_ctx(feature_context * ctx) {
+    return CO_HistogramAMI_even_ctx(ctx, 10, 3);
+}
+
+double CO_HistogramAMI_even_2_3_ctx(feature_context * ctx) {
+    return CO_HistogramAMI_even_ctx(ctx, 2, 3);
+}
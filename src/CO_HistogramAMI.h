@@ -1,9 +1,25 @@
 #ifndef CO_HISTOGRAMAMI_H
 #define CO_HISTOGRAMAMI_H
 
+#include "feature_context.h"
+
+// largest bin count CO_HistogramAMI_even_multi accepts; the joint histogram
+// grows with its square
+#define CO_HISTOGRAMAMI_MAX_BINS 1000
+
 extern double CO_HistogramAMI_even(const double y[], const int size, int numBins, int tau);
 extern double CO_HistogramAMI_even_10_1(const double y[], const int size);
 extern double CO_HistogramAMI_even_10_3(const double y[], const int size);
 extern double CO_HistogramAMI_even_2_3(const double y[], const int size);
+extern double CO_HistogramAMI_even_ctx(feature_context * ctx, int numBins, int tau);
+extern double CO_HistogramAMI_even_10_1_ctx(feature_context * ctx);
+extern double CO_HistogramAMI_even_10_3_ctx(feature_context * ctx);
+extern double CO_HistogramAMI_even_2_3_ctx(feature_context * ctx);
+// AMI for n (numBins[k], tau[k]) pairs. The series is binned once per
+// distinct bin count and each lag is counted from the shared labels;
+// pairs with tau >= size or numBins outside 1..CO_HISTOGRAMAMI_MAX_BINS give
+// NaN.
+extern void CO_HistogramAMI_even_multi(const double y[], const int size, const int numBins[], const int tau[], const int n, double out[]);
+extern void CO_HistogramAMI_even_multi_ctx(feature_context * ctx, const int numBins[], const int tau[], const int n, double out[]);
 
 #endif
@@ -3,6 +3,7 @@
 #include "stats.h"
 
 #include "CO_NonlinearAutocorr.h"
+#include "feature_context.h"
 
 double CO_NonlinearAutocorr(const double y[], const int size, const int taus[]) {
 
@@ -27,6 +28,27 @@ double CO_NonlinearAutocorr(const double y[], const int size, const int taus[])
     return out;
 }
 
+double AC_nl_035_ctx(feature_context * ctx) {
+    
+    int taus[3] = {0,3,5};
+
+    return CO_NonlinearAutocorr(context_y(ctx), ctx->size, taus);
+}
+
+double AC_nl_036_ctx(feature_context * ctx) {
+    
+    int taus[3] = {0,3,6};
+
+    return CO_NonlinearAutocorr(context_y(ctx), ctx->size, taus);
+}
+
+double AC_nl_112_ctx(feature_context * ctx) {
+
+    int taus[3] = {1,1,2};
+    
+    return CO_NonlinearAutocorr(context_y(ctx), ctx->size, taus);
+}
+
 double AC_nl_035(const double y[], const int size) {
     
     int taus[3] = {0,3,5};
@@ -1,9 +1,14 @@
 #ifndef CO_NONLINEARAC_H
 #define CO_NONLINEARAC_H
 
+#include "feature_context.h"
+
 extern double CO_NonlinearAutocorr(const double y[], const int size, const int taus[]);
 extern double AC_nl_036(const double y[], const int size);
 extern double AC_nl_035(const double y[], const int size);
 extern double AC_nl_112(const double y[], const int size);
+extern double AC_nl_036_ctx(feature_context * ctx);
+extern double AC_nl_035_ctx(feature_context * ctx);
+extern double AC_nl_112_ctx(feature_context * ctx);
 
 #endif
@@ -5,14 +5,17 @@
 #include "CO_TranslateShape.h"
 #include "SY_SlidingWindow.h"
 #include "stats.h"
+#include "feature_context.h"
 
-double CO_TranslateShape_circle_35_pts(const double y[], const int size, const char whichOut[]) {
+double CO_TranslateShape_circle_35_pts_ctx(feature_context * ctx, const char whichOut[]) {
     
     // NAN check
     int i, j;
-    for (i = 0; i < size; i++)
-        if (isnan(y[i]))
-            return NAN;
+    if (context_has_nan(ctx))
+        return NAN;
+    
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
     
     double r = 3.5;
     int w = floor(r); // only consider a window radius w (these are the only
@@ -48,6 +51,14 @@ double CO_TranslateShape_circle_35_pts(const double y[], const int size, const c
     return out;
 }
 
+double CO_TranslateShape_circle_35_pts(const double y[], const int size, const char whichOut[]) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = CO_TranslateShape_circle_35_pts_ctx(&ctx, whichOut);
+    context_free(&ctx);
+    return out;
+}
+
 double CO_TranslateShape_circle_35_pts_statav4_m(const double y[], const int size) {
     return CO_TranslateShape_circle_35_pts(y, size, "statav4_m");
 }
@@ -55,3 +66,11 @@ double CO_TranslateShape_circle_35_pts_statav4_m(const double y[], const int siz
 double CO_TranslateShape_circle_35_pts_std(const double y[], const int size) {
     return CO_TranslateShape_circle_35_pts(y, size, "std");
 }
+
+double CO_TranslateShape_circle_35_pts_statav4_m_ctx(feature_context * ctx) {
+    return CO_TranslateShape_circle_35_pts_ctx(ctx, "statav4_m");
+}
+
+double CO_TranslateShape_circle_35_pts_std_ctx(feature_context * ctx) {
+    return CO_TranslateShape_circle_35_pts_ctx(ctx, "std");
+}
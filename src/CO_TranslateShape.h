@@ -1,8 +1,13 @@
 #ifndef CO_TRANSLATESHAPE_H
 #define CO_TRANSLATESHAPE_H
 
+#include "feature_context.h"
+
 extern double CO_TranslateShape_circle_35_pts(const double y[], const int size, const char whichOut[]);
 extern double CO_TranslateShape_circle_35_pts_statav4_m(const double y[], const int size);
 extern double CO_TranslateShape_circle_35_pts_std(const double y[], const int size);
+extern double CO_TranslateShape_circle_35_pts_ctx(feature_context * ctx, const char whichOut[]);
+extern double CO_TranslateShape_circle_35_pts_statav4_m_ctx(feature_context * ctx);
+extern double CO_TranslateShape_circle_35_pts_std_ctx(feature_context * ctx);
 
 #endif
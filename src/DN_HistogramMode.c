@@ -0,0 +1,116 @@
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include "stats.h"
+#include "histcounts.h"
+#include "feature_context.h"
+#include "DN_HistogramMode.h"
+
+#define HISTMODE_STACK_COUNTS 256
+#define HISTMODE_STACK_ENTRIES 16
+
+// centre of the most populated bin, averaged over ties
+static double histogram_mode(const int histCounts[], const int nBins, const double minVal, const double maxVal)
+{
+    // bin edges as histcounts_range gives them
+    const double binStep = (maxVal - minVal)/nBins;
+    
+    double maxCount = 0;
+    int numMaxs = 1;
+    double out = 0;
+    for(int i = 0; i < nBins; i++)
+    {
+        if (histCounts[i] > maxCount)
+        {
+            maxCount = histCounts[i];
+            numMaxs = 1;
+            out = ((i * binStep + minVal) + ((i+1) * binStep + minVal))*0.5;
+        }
+        else if (histCounts[i] == maxCount){
+            
+            numMaxs += 1;
+            out += ((i * binStep + minVal) + ((i+1) * binStep + minVal))*0.5;
+        }
+    }
+    return out/numMaxs;
+}
+
+void DN_HistogramMode_multi_ctx(feature_context * ctx, const int nBins[], const int n, double out[])
+{
+    // NaN check
+    if(context_has_nan(ctx))
+    {
+        for(int k = 0; k < n; k++)
+            out[k] = NAN;
+        return;
+    }
+    
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
+    const double minVal = context_min(ctx);
+    const double maxVal = context_max(ctx);
+    
+    // counts on the stack unless the caller asks for many bins
+    size_t total = 0;
+    int nCounted = 0;
+    for(int k = 0; k < n; k++)
+        if(nBins[k] > 0 && nBins[k] <= DN_HISTOGRAMMODE_MAX_BINS)
+        {
+            total += nBins[k];
+            nCounted++;
+        }
+    
+    int stackCounts[HISTMODE_STACK_COUNTS];
+    int stackValid[HISTMODE_STACK_ENTRIES];
+    int * histCounts = total <= HISTMODE_STACK_COUNTS ? stackCounts : malloc(total * sizeof(int));
+    int * nValid = nCounted <= HISTMODE_STACK_ENTRIES ? stackValid : malloc(nCounted * sizeof(int));
+    nCounted = 0;
+    for(int k = 0; k < n; k++)
+        if(nBins[k] > 0 && nBins[k] <= DN_HISTOGRAMMODE_MAX_BINS)
+            nValid[nCounted++] = nBins[k];
+    
+    histcounts_multi(y, size, minVal, maxVal, nValid, nCounted, histCounts);
+    
+    size_t offset = 0;
+    for(int k = 0; k < n; k++)
+    {
+        if(nBins[k] < 1 || nBins[k] > DN_HISTOGRAMMODE_MAX_BINS)
+        {
+            out[k] = NAN;
+            continue;
+        }
+        out[k] = histogram_mode(histCounts + offset, nBins[k], minVal, maxVal);
+        offset += nBins[k];
+    }
+    
+    if(histCounts != stackCounts)
+        free(histCounts);
+    if(nValid != stackValid)
+        free(nValid);
+}
+
+void DN_HistogramMode_multi(const double y[], const int size, const int nBins[], const int n, double out[])
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    DN_HistogramMode_multi_ctx(&ctx, nBins, n, out);
+    context_free(&ctx);
+}
+
+void DN_HistogramMode_5_10_ctx(feature_context * ctx, double out[2])
+{
+    if(ctx->haveHistogramMode)
+    {
+        out[0] = ctx->histogramMode[0];
+        out[1] = ctx->histogramMode[1];
+        return;
+    }
+    
+    // the 5 bin counts are merged from the 10 bin ones
+    const int nBins[2] = {5, 10};
+    DN_HistogramMode_multi_ctx(ctx, nBins, 2, out);
+    
+    ctx->histogramMode[0] = out[0];
+    ctx->histogramMode[1] = out[1];
+    ctx->haveHistogramMode = 1;
+}
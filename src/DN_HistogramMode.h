@@ -0,0 +1,20 @@
+#ifndef DN_HISTOGRAMMODE
+#define DN_HISTOGRAMMODE
+#include <math.h>
+#include <string.h>
+#include "stats.h"
+#include "feature_context.h"
+
+// largest bin count DN_HistogramMode_multi accepts (and the most bins the R
+// export allows in total)
+#define DN_HISTOGRAMMODE_MAX_BINS 1000000
+
+// DN_HistogramMode at n bin counts nBins[k] from one min/max and one counting
+// pass; out[k] is NaN for nBins[k] outside 1..DN_HISTOGRAMMODE_MAX_BINS
+extern void DN_HistogramMode_multi(const double y[], const int size, const int nBins[], const int n, double out[]);
+extern void DN_HistogramMode_multi_ctx(feature_context * ctx, const int nBins[], const int n, double out[]);
+// the 5 and 10 bin modes at once, out = {5, 10}; the context keeps the pair
+// for DN_HistogramMode_5_ctx and DN_HistogramMode_10_ctx
+extern void DN_HistogramMode_5_10_ctx(feature_context * ctx, double out[2]);
+
+#endif
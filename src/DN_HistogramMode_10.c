@@ -5,50 +5,23 @@
 
 #include "stats.h"
 #include "histcounts.h"
+#include "feature_context.h"
+#include "DN_HistogramMode.h"
+
+double DN_HistogramMode_10_ctx(feature_context * ctx)
+{
+    // computed together with the 5 bin mode
+    double out[2];
+    DN_HistogramMode_5_10_ctx(ctx, out);
+    return out[1];
+}
 
 double DN_HistogramMode_10(const double y[], const int size)
 {
-    // NaN check
-    for(int i = 0; i < size; i++)
-    {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
-    }
-    
-    const int nBins = 10;
-    
-    int * histCounts;
-    double * binEdges;
-    
-    histcounts(y, size, nBins, &histCounts, &binEdges);
-    
-    double maxCount = 0;
-    int numMaxs = 1;
-    double out = 0;;
-    for(int i = 0; i < nBins; i++)
-    {
-        // printf("binInd=%i, binCount=%i, binEdge=%1.3f \n", i, histCounts[i], binEdges[i]);
-        
-        if (histCounts[i] > maxCount)
-        {
-            maxCount = histCounts[i];
-            numMaxs = 1;
-            out = (binEdges[i] + binEdges[i+1])*0.5;
-        }
-        else if (histCounts[i] == maxCount){
-            
-            numMaxs += 1;
-            out += (binEdges[i] + binEdges[i+1])*0.5;
-        }
-    }
-    out = out/numMaxs;
-    
-    // arrays created dynamically in function histcounts
-    free(histCounts);
-    free(binEdges);
-    
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = DN_HistogramMode_10_ctx(&ctx);
+    context_free(&ctx);
     return out;
 }
 
@@ -3,7 +3,9 @@
 #include <math.h>
 #include <string.h>
 #include "stats.h"
+#include "feature_context.h"
 
 extern double DN_HistogramMode_10(const double y[], const int size);
+extern double DN_HistogramMode_10_ctx(feature_context * ctx);
 
 #endif
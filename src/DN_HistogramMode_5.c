@@ -4,60 +4,23 @@
 #include <float.h>
 #include "stats.h"
 #include "histcounts.h"
+#include "feature_context.h"
+#include "DN_HistogramMode.h"
+
+double DN_HistogramMode_5_ctx(feature_context * ctx)
+{
+    // computed together with the 10 bin mode
+    double out[2];
+    DN_HistogramMode_5_10_ctx(ctx, out);
+    return out[0];
+}
 
 double DN_HistogramMode_5(const double y[], const int size)
 {
-    
-    // NaN check
-    for(int i = 0; i < size; i++)
-    {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
-    }
-    
-    const int nBins = 5;
-    
-    int * histCounts;
-    double * binEdges;
-    
-    histcounts(y, size, nBins, &histCounts, &binEdges);
-    
-    /*
-    for(int i = 0; i < nBins; i++){
-        printf("histCounts[%i] = %i\n", i, histCounts[i]);
-    }
-    for(int i = 0; i < nBins+1; i++){
-        printf("binEdges[%i] = %1.3f\n", i, binEdges[i]);
-    }
-     */
-    
-    double maxCount = 0;
-    int numMaxs = 1;
-    double out = 0;;
-    for(int i = 0; i < nBins; i++)
-    {
-        // printf("binInd=%i, binCount=%i, binEdge=%1.3f \n", i, histCounts[i], binEdges[i]);
-        
-        if (histCounts[i] > maxCount)
-        {
-            maxCount = histCounts[i];
-            numMaxs = 1;
-            out = (binEdges[i] + binEdges[i+1])*0.5;
-        }
-        else if (histCounts[i] == maxCount){
-            
-            numMaxs += 1;
-            out += (binEdges[i] + binEdges[i+1])*0.5;
-        }
-    }
-    out = out/numMaxs;
-    
-    // arrays created dynamically in function histcounts
-    free(histCounts);
-    free(binEdges);
-    
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = DN_HistogramMode_5_ctx(&ctx);
+    context_free(&ctx);
     return out;
 }
 
@@ -3,7 +3,9 @@
 #include <math.h>
 #include <string.h>
 #include "stats.h"
+#include "feature_context.h"
 
 extern double DN_HistogramMode_5(const double y[], const int size);
+extern double DN_HistogramMode_5_ctx(feature_context * ctx);
 
 #endif
@@ -5,131 +5,218 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "stats.h"
+#include "feature_context.h"
 
-double DN_OutlierInclude_np_001_mdrmd(const double y[], const int size, const int sign)
+typedef struct outlier_sample {
+    double value;
+    int index;
+} outlier_sample;
+
+static int outlier_sample_cmp(const void * a, const void * b)
 {
-    
-    // NaN check
-    for(int i = 0; i < size; i++)
-    {
-        if(isnan(y[i]))
-        {
-            return NAN;
+    const outlier_sample * x = a;
+    const outlier_sample * y = b;
+    if (x->value < y->value) return -1;
+    if (x->value > y->value) return 1;
+    return x->index - y->index;
+}
+
+// Fenwick tree over the time indices 1..size, counting the indices that
+// currently exceed the threshold; kth gives order statistics in O(log size)
+static void fenwick_add(int tree[], const int size, int i)
+{
+    for (; i <= size; i += i & -i) {
+        tree[i] += 1;
+    }
+}
+
+// smallest index i with at least k counted indices <= i
+static int fenwick_kth(const int tree[], const int size, int k)
+{
+    int pos = 0;
+    int step = 1;
+    while (step * 2 <= size) {
+        step *= 2;
+    }
+    for (; step > 0; step /= 2) {
+        if (pos + step <= size && tree[pos + step] < k) {
+            pos += step;
+            k -= tree[pos];
         }
     }
-    
+    return pos + 1;
+}
+
+// One signed variant, given the samples in ascending order of value.
+static double outlier_include_sweep(const double y[], const int size, const outlier_sample order[],
+                                    const int sign, const double maxVal)
+{
     double inc = 0.01;
-    int tot = 0;
-    double * yWork = malloc(size * sizeof(double));
     
-    // apply sign and check constant time series
-    int constantFlag = 1;
+    // maximum value too small? return 0
+    if(maxVal < inc){
+        return 0;
+    }
+    
+    // count pos/ negs
+    int tot = 0;
     for(int i = 0; i < size; i++)
     {
-        if(y[i] != y[0])
-        {
-            constantFlag = 0;
-        }
-        
-        // apply sign, save in new variable
-        yWork[i] = sign*y[i];
-        
-        // count pos/ negs
-        if(yWork[i] >= 0){
+        if(sign*y[i] >= 0){
             tot += 1;
         }
-        
-    }
-    if(constantFlag) return 0; // if constant, return 0
-    
-    // find maximum (or minimum, depending on sign)
-    double maxVal = max_(yWork, size);
-    
-    // maximum value too small? return 0
-    if(maxVal < inc){
-        return 0;
     }
     
     int nThresh = maxVal/inc + 1;
     
-    // save the indices where y > threshold
-    double * r = malloc(size * sizeof * r);
-    
-    // save the median over indices with absolute value > threshold
-    double * msDti1 = malloc(nThresh * sizeof(double));
+    // Sweep the thresholds from high to low. Samples enter the exceedance
+    // set once, in order of sign*y (walking order from the end for sign > 0
+    // and from the start for sign < 0); the set's size and median time index
+    // are kept in the Fenwick tree. The mean interval between exceedances is
+    // only tested for NaN, which happens exactly when one sample exceeds.
+    int * tree = calloc(size + 1, sizeof * tree);
     double * msDti3 = malloc(nThresh * sizeof(double));
     double * msDti4 = malloc(nThresh * sizeof(double));
+    int fbi = nThresh-1;
     
-    for(int j = 0; j < nThresh; j++)
+    int highSize = 0;
+    for(int j = nThresh-1; j >= 0; j--)
     {
-        //printf("j=%i, thr=%1.3f\n", j, j*inc);
-        
-        int highSize = 0;
-        
-        for(int i = 0; i < size; i++)
+        while(highSize < size)
         {
-            if(yWork[i] >= j*inc)
+            const outlier_sample * next = sign > 0 ? &order[size-1-highSize] : &order[highSize];
+            if(!(sign*next->value >= j*inc))
             {
-                r[highSize] = i+1;
-                //printf("r[%i]=%1.f \n", highSize, r[highSize]);
-                highSize += 1;
+                break;
             }
+            // time indices are counted from 1
+            fenwick_add(tree, size, next->index + 1);
+            highSize += 1;
         }
         
-        // intervals between high-values
-        double * Dt_exc = malloc(highSize * sizeof(double));
-        
-        for(int i = 0; i < highSize-1; i++)
+        double medianInd;
+        if(highSize == 0)
         {
-            //printf("i=%i, r[i+1]=%1.f, r[i]=%1.f \n", i, r[i+1], r[i]);
-            Dt_exc[i] = r[i+1] - r[i];
+            medianInd = NAN;
+        }
+        else if(highSize % 2 == 1)
+        {
+            medianInd = fenwick_kth(tree, size, highSize/2 + 1);
+        }
+        else
+        {
+            medianInd = (fenwick_kth(tree, size, highSize/2) + fenwick_kth(tree, size, highSize/2 + 1)) / 2.0;
         }
-
-        /*
-        // median
-        double medianOut;
-        medianOut = median(r, highSize);
-        */
-         
-        msDti1[j] = mean(Dt_exc, highSize-1);
-        msDti3[j] = (highSize-1)*100.0/tot;
-        msDti4[j] = median(r, highSize) / ((double)size/2) - 1;
-        
-        //printf("msDti1[%i] = %1.3f, msDti13[%i] = %1.3f, msDti4[%i] = %1.3f\n",
-        //       j, msDti1[j], j, msDti3[j], j, msDti4[j]);
         
-        free(Dt_exc);
+        msDti3[j] = (highSize-1)*100.0/tot;
+        msDti4[j] = medianInd / ((double)size/2) - 1;
         
+        if(highSize == 1)
+        {
+            fbi = j;
+        }
     }
     
     int trimthr = 2;
     int mj = 0;
-    int fbi = nThresh-1;
     for(int i = 0; i < nThresh; i ++)
     {
         if (msDti3[i] > trimthr)
         {
             mj = i;
         }
-        if (isnan(msDti1[nThresh-1-i]))
-        {
-            fbi = nThresh-1-i;
-        }
     }
     
     double outputScalar;
     int trimLimit = mj < fbi ? mj : fbi;
     outputScalar = median(msDti4, trimLimit+1);
     
-    free(r);
-    free(yWork);
-    free(msDti1);
+    free(tree);
     free(msDti3);
     free(msDti4);
     
     return outputScalar;
 }
 
+void DN_OutlierInclude_pn_001_mdrmd_ctx(feature_context * ctx, double out[2])
+{
+    if(ctx->haveOutlierInclude)
+    {
+        out[0] = ctx->outlierInclude[0];
+        out[1] = ctx->outlierInclude[1];
+        return;
+    }
+    
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
+    
+    // NaN check
+    if(context_has_nan(ctx))
+    {
+        out[0] = out[1] = NAN;
+    }
+    // check constant time series
+    else if(context_min(ctx) == context_max(ctx))
+    {
+        out[0] = out[1] = 0; // if constant, return 0
+    }
+    else
+    {
+        // samples in ascending order of value, shared by both signs
+        outlier_sample * order = malloc(size * sizeof * order);
+        for(int i = 0; i < size; i++)
+        {
+            order[i].value = y[i];
+            order[i].index = i;
+        }
+        qsort(order, size, sizeof * order, outlier_sample_cmp);
+        
+        // the sweep starts from the maximum (or minimum, depending on sign)
+        out[0] = outlier_include_sweep(y, size, order, 1, context_max(ctx));
+        out[1] = outlier_include_sweep(y, size, order, -1, -context_min(ctx));
+        
+        free(order);
+    }
+    
+    ctx->outlierInclude[0] = out[0];
+    ctx->outlierInclude[1] = out[1];
+    ctx->haveOutlierInclude = 1;
+}
+
+double DN_OutlierInclude_np_001_mdrmd_ctx(feature_context * ctx, const int sign)
+{
+    double out[2];
+    DN_OutlierInclude_pn_001_mdrmd_ctx(ctx, out);
+    return sign > 0 ? out[0] : out[1];
+}
+
+double DN_OutlierInclude_np_001_mdrmd(const double y[], const int size, const int sign)
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = DN_OutlierInclude_np_001_mdrmd_ctx(&ctx, sign);
+    context_free(&ctx);
+    return out;
+}
+
+void DN_OutlierInclude_pn_001_mdrmd(const double y[], const int size, double out[2])
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    DN_OutlierInclude_pn_001_mdrmd_ctx(&ctx, out);
+    context_free(&ctx);
+}
+
+double DN_OutlierInclude_p_001_mdrmd_ctx(feature_context * ctx)
+{
+    return DN_OutlierInclude_np_001_mdrmd_ctx(ctx, 1.0);
+}
+
+double DN_OutlierInclude_n_001_mdrmd_ctx(feature_context * ctx)
+{
+    return DN_OutlierInclude_np_001_mdrmd_ctx(ctx, -1.0);
+}
+
 double DN_OutlierInclude_p_001_mdrmd(const double y[], const int size)
 {
     return DN_OutlierInclude_np_001_mdrmd(y, size, 1.0);
@@ -5,10 +5,18 @@
 #include <time.h>
 #include <float.h>
 #include "stats.h"
+#include "feature_context.h"
 
 extern double DN_OutlierInclude_abs_001(const double y[], const int size);
 extern double DN_OutlierInclude_np_001_mdrmd(const double y[], const int size, const int sign);
 extern double DN_OutlierInclude_p_001_mdrmd(const double y[], const int size);
 extern double DN_OutlierInclude_n_001_mdrmd(const double y[], const int size);
+extern double DN_OutlierInclude_np_001_mdrmd_ctx(feature_context * ctx, const int sign);
+// both signed variants at once, out = {p, n}; they share one sort of the
+// series, and the context keeps the pair for the single-variant calls
+extern void DN_OutlierInclude_pn_001_mdrmd(const double y[], const int size, double out[2]);
+extern void DN_OutlierInclude_pn_001_mdrmd_ctx(feature_context * ctx, double out[2]);
+extern double DN_OutlierInclude_p_001_mdrmd_ctx(feature_context * ctx);
+extern double DN_OutlierInclude_n_001_mdrmd_ctx(feature_context * ctx);
 
 #endif
@@ -6,6 +6,7 @@
 #include "CO_AutoCorr.h"
 #include "DN_RemovePoints.h"
 #include "helper_functions.h"
+#include "feature_context.h"
 
 
 // Comparator for struct array type, to sort in descending order
@@ -44,13 +45,15 @@ double* SUB_acf(const double y[], const int size, double acf[], int lag) {
     return acf;
 }
 
-double DN_RemovePoints_absclose_05_ac2rat(const double y[], const int size) {
+double DN_RemovePoints_absclose_05_ac2rat_ctx(feature_context * ctx) {
     
     // NaN check
     int i;
-    for (i = 0; i < size; i++)
-        if (isnan(y[i]))
-            return NAN;
+    if (context_has_nan(ctx))
+        return NAN;
+    
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
 
     // Sort the array with absolute values
     struct array *abs_y = (struct array*) malloc(size * sizeof(struct array));
@@ -73,13 +76,22 @@ double DN_RemovePoints_absclose_05_ac2rat(const double y[], const int size) {
         yTransform[i] = y[sorted_ind[i]];
     
     int tau[1] = {2};
-    double acf_y = *CO_AutoCorr(y, size, tau, 1);
-    double acf_yTransform = *CO_AutoCorr(yTransform, keep_size, tau, 1);
-    double ac2rat = acf_yTransform/acf_y;
+    double acf_y = context_acf(ctx, 2);
+    double * acf_yTransform = CO_AutoCorr(yTransform, keep_size, tau, 1);
+    double ac2rat = acf_yTransform[0]/acf_y;
 
+    free(acf_yTransform);
     free(abs_y);
     free(sorted_ind);
     free(yTransform);    
 
     return ac2rat;
 }
+
+double DN_RemovePoints_absclose_05_ac2rat(const double y[], const int size) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = DN_RemovePoints_absclose_05_ac2rat_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
@@ -1,6 +1,8 @@
 #ifndef DN_REMOVEPOINTS_H
 #define DN_REMOVEPOINTS_H
 
+#include "feature_context.h"
+
 // struct for storing the sorted array 
 // elements with it's original index.
 struct array {
@@ -14,5 +16,6 @@ void abs_array(const double y[], int size, struct array *abs_y);
 
 extern double* SUB_acf(const double y[], const int size, double acf[], int lag);
 extern double DN_RemovePoints_absclose_05_ac2rat(const double y[], const int size);
+extern double DN_RemovePoints_absclose_05_ac2rat_ctx(feature_context * ctx);
 
 #endif
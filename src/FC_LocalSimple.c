@@ -23,84 +23,185 @@ double fc_local_simple(const double y[], const int size, const int train_length)
     return m;
 }
 
-double FC_LocalSimple_mean_tauresrat(const double y[], const int size, const int train_length)
+// Compensated prefix sums: hi[i] + lo[i] is the sum of y[0..i-1] to about
+// twice working precision, so a window sum taken as a difference of two
+// entries is as accurate as summing the window directly, also for long
+// series far from zero mean. hi and lo have size+1 entries.
+static void fc_prefix_sums(const double y[], const int size, double hi[], double lo[])
+{
+    hi[0] = 0.0;
+    lo[0] = 0.0;
+    for (int i = 0; i < size; i++)
+    {
+        double s = hi[i] + y[i];
+        double bb = s - hi[i];
+        lo[i+1] = lo[i] + ((hi[i] - (s - bb)) + (y[i] - bb));
+        hi[i+1] = s;
+    }
+}
+
+// sum of y[a..b-1]
+static inline double fc_window_sum(const double hi[], const double lo[], const int a, const int b)
+{
+    return (hi[b] - hi[a]) + (lo[b] - lo[a]);
+}
+
+// residuals res[i] = y[i+train_length] - mean(y[i..i+train_length-1]) of
+// the local mean forecast, size - train_length of them
+static void fc_mean_residuals(const double y[], const int size, const double hi[], const double lo[],
+                              const int train_length, double res[])
+{
+    for (int i = 0; i < size - train_length; i++)
+    {
+        double yest = fc_window_sum(hi, lo, i, i + train_length) / train_length;
+        res[i] = y[i+train_length] - yest;
+    }
+}
+
+#define FC_MULTI_STACK 16
+
+void FC_LocalSimple_mean_stderr_multi_ctx(feature_context * ctx, const int train_lengths[], const int n, double out[])
 {
+    if (n < 1)
+        return;
 
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
+        for (int k = 0; k < n; k++)
+            out[k] = NAN;
+        return;
     }
 
-    double * res = malloc((size - train_length) * sizeof *res);
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
+
+    double * hi = malloc(2 * (size + 1) * sizeof *hi);
+    double * lo = hi + size + 1;
+    fc_prefix_sums(y, size, hi, lo);
+
+    // running mean and sum of squared deviations of the residuals for every
+    // training length (Welford), updated in one pass over the targets; on the
+    // stack for the usual handful of lengths
+    double stackStats[2*FC_MULTI_STACK];
+    int stackCount[FC_MULTI_STACK];
+    double * resMean = n <= FC_MULTI_STACK ? stackStats : malloc(2 * (size_t)n * sizeof *resMean);
+    double * resM2 = resMean + n;
+    int * count = n <= FC_MULTI_STACK ? stackCount : malloc((size_t)n * sizeof *count);
+    for (int k = 0; k < n; k++)
+    {
+        resMean[k] = 0.0;
+        resM2[k] = 0.0;
+        count[k] = 0;
+    }
 
-    for (int i = 0; i < size - train_length; i++)
+    for (int t = 1; t < size; t++)
     {
-        double yest = 0;
-        for (int j = 0; j < train_length; j++)
+        for (int k = 0; k < n; k++)
         {
-            yest += y[i+j];
-
+            const int train_length = train_lengths[k];
+            if (train_length < 1 || train_length > t)
+                continue;
+            double res = y[t] - fc_window_sum(hi, lo, t - train_length, t) / train_length;
+            count[k] += 1;
+            double delta = res - resMean[k];
+            resMean[k] += delta / count[k];
+            resM2[k] += delta * (res - resMean[k]);
         }
-        yest /= train_length;
-
-        res[i] = y[i+train_length] - yest;
     }
 
-    double resAC1stZ = co_firstzero(res, size - train_length, size - train_length);
-    double yAC1stZ = co_firstzero(y, size, size);
-    double output = resAC1stZ/yAC1stZ;
+    for (int k = 0; k < n; k++)
+    {
+        out[k] = count[k] < 2 ? NAN : sqrt(resM2[k] / (count[k] - 1));
+    }
 
-    free(res);
-    return output;
+    free(hi);
+    if (resMean != stackStats)
+        free(resMean);
+    if (count != stackCount)
+        free(count);
+}
 
+void FC_LocalSimple_mean_stderr_multi(const double y[], const int size, const int train_lengths[], const int n, double out[])
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    FC_LocalSimple_mean_stderr_multi_ctx(&ctx, train_lengths, n, out);
+    context_free(&ctx);
 }
 
-double FC_LocalSimple_mean_stderr(const double y[], const int size, const int train_length)
+double FC_LocalSimple_mean_tauresrat_ctx(feature_context * ctx, const int train_length)
 {
+
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
+        return NAN;
     }
 
-    double * res = malloc((size - train_length) * sizeof *res);
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
 
-    for (int i = 0; i < size - train_length; i++)
-    {
-        double yest = 0;
-        for (int j = 0; j < train_length; j++)
-        {
-            yest += y[i+j];
-
-        }
-        yest /= train_length;
+    double * res = malloc((size - train_length) * sizeof *res);
+    double * hi = malloc(2 * (size + 1) * sizeof *hi);
+    double * lo = hi + size + 1;
 
-        res[i] = y[i+train_length] - yest;
-    }
+    fc_prefix_sums(y, size, hi, lo);
+    fc_mean_residuals(y, size, hi, lo, train_length, res);
+    free(hi);
 
-    double output = stddev(res, size - train_length);
+    double resAC1stZ = co_firstzero(res, size - train_length, size - train_length);
+    double yAC1stZ = context_firstzero(ctx);
+    double output = resAC1stZ/yAC1stZ;
 
     free(res);
     return output;
 
 }
 
+double FC_LocalSimple_mean_tauresrat(const double y[], const int size, const int train_length)
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = FC_LocalSimple_mean_tauresrat_ctx(&ctx, train_length);
+    context_free(&ctx);
+    return out;
+}
+
+double FC_LocalSimple_mean_stderr_ctx(feature_context * ctx, const int train_length)
+{
+    double out;
+    FC_LocalSimple_mean_stderr_multi_ctx(ctx, &train_length, 1, &out);
+    return out;
+}
+
+double FC_LocalSimple_mean_stderr(const double y[], const int size, const int train_length)
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = FC_LocalSimple_mean_stderr_ctx(&ctx, train_length);
+    context_free(&ctx);
+    return out;
+}
+
 double FC_LocalSimple_mean3_stderr(const double y[], const int size)
 {
     return FC_LocalSimple_mean_stderr(y, size, 3);
 }
 
+double FC_LocalSimple_mean3_stderr_ctx(feature_context * ctx)
+{
+    return FC_LocalSimple_mean_stderr_ctx(ctx, 3);
+}
+
 double FC_LocalSimple_mean1_tauresrat(const double y[], const int size){
     return FC_LocalSimple_mean_tauresrat(y, size, 1);
 }
 
+double FC_LocalSimple_mean1_tauresrat_ctx(feature_context * ctx){
+    return FC_LocalSimple_mean_tauresrat_ctx(ctx, 1);
+}
+
 double FC_LocalSimple_mean_taures(const double y[], const int size, const int train_length)
 {
     double * res = malloc((size - train_length) * sizeof *res);
@@ -167,64 +268,54 @@ double FC_LocalSimple_lfit_taures(const double y[], const int size)
 double FC_LocalSimple_cam(const double y[], const int size, int trainLength) {
 
     // Method:- mean
-    int i, j;
-    int lp = trainLength;
-
     // range over which to evaluate
-    int evalr_len = size - lp; //lp+1:N
+    int evalr_len = size - trainLength; //lp+1:N
     if (evalr_len == 0) {
         printf("FC_LocalSimple: Time Series too short for forecasting\n");
         return NAN;
     }
-    int *evalr = (int*) malloc(evalr_len * sizeof(int));
-    for (i = 0; i < evalr_len; i++)
-        evalr[i] = i + lp + 1;
-
-    double *res = (double*) malloc(evalr_len * sizeof(double));
-    memset(res, 0, evalr_len * sizeof(double));
-    for (i = 0; i < evalr_len; i++) {
-        for (j = evalr[i] - lp - 1; j < evalr[i] - 1; j++)
-            res[i] += y[j];
-        res[i] = (res[i]/lp) - y[evalr[i] - 1];
-    }
 
-    double out = stddev(res, evalr_len);
-    /*out[1] = SY_SlidingWindow(res, evalr_len, "std", "std", 5, 1); // sws
-     out[2] = SY_SlidingWindow(res, evalr_len, "mean", "std", 5, 1); // swm
-     int tau[1] = {1};
-     out[3] = *CO_AutoCorr(res, evalr_len, tau, 1); // ac1
-     tau[0] = 2;
-     out[4] = *CO_AutoCorr(res, evalr_len, tau, 1); // ac2*/
-
-    free(evalr);
-    free(res);
-    return out;
+    // the residual sign (forecast minus value) does not change the std
+    return FC_LocalSimple_mean_stderr(y, size, trainLength);
 }
 
-double FC_LoopLocalSimple_mean_stderr_chn(const double y[], const int size) {
+double FC_LoopLocalSimple_mean_stderr_chn_ctx(feature_context * ctx) {
 
     // Check NAN
     int i;
-    for (i = 0; i < size; i++)
-        if (isnan(y[i]))
-            return NAN;
-
-        int trainLengthRange = 10;
-        double *stats_st = (double*) malloc(trainLengthRange * sizeof(double)); // 10 x 5 matrix
-        double mi = INT_MAX, ma = -INT_MAX;
-        for (i = 0; i < trainLengthRange; i++) {
-            stats_st[i] = FC_LocalSimple_cam(y, size, i+1);
-            if (mi > stats_st[i])   mi = stats_st[i];
-            if (ma < stats_st[i])   ma = stats_st[i];
-        }
-        double range = ma - mi;
+    if (context_has_nan(ctx))
+        return NAN;
 
-        double *st_diff = (double*) malloc((trainLengthRange - 1) * sizeof(double));
-        diff(stats_st, trainLengthRange, st_diff);
-        double stderr_chn = mean(st_diff, trainLengthRange - 1)/ range;
+    int trainLengthRange = 10;
+    double *stats_st = (double*) malloc(trainLengthRange * sizeof(double)); // 10 x 5 matrix
+    int trainLengths[10];
+    for (i = 0; i < trainLengthRange; i++)
+        trainLengths[i] = i+1;
+
+    // all training lengths from one pass
+    FC_LocalSimple_mean_stderr_multi_ctx(ctx, trainLengths, trainLengthRange, stats_st);
+
+    double mi = INT_MAX, ma = -INT_MAX;
+    for (i = 0; i < trainLengthRange; i++) {
+        if (mi > stats_st[i])   mi = stats_st[i];
+        if (ma < stats_st[i])   ma = stats_st[i];
+    }
+    double range = ma - mi;
 
-        free(stats_st);
-        free(st_diff);
+    double *st_diff = (double*) malloc((trainLengthRange - 1) * sizeof(double));
+    diff(stats_st, trainLengthRange, st_diff);
+    double stderr_chn = mean(st_diff, trainLengthRange - 1)/ range;
 
-        return stderr_chn;
+    free(stats_st);
+    free(st_diff);
+
+    return stderr_chn;
+}
+
+double FC_LoopLocalSimple_mean_stderr_chn(const double y[], const int size) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = FC_LoopLocalSimple_mean_stderr_chn_ctx(&ctx);
+    context_free(&ctx);
+    return out;
 }
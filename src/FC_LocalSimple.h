@@ -4,6 +4,7 @@
 #include <string.h>
 #include "stats.h"
 #include "CO_AutoCorr.h"
+#include "feature_context.h"
 
 extern double fc_local_simple(const double y[], const int size, const int train_length);
 extern double FC_LocalSimple_mean_taures(const double y[], const int size, const int train_length);
@@ -15,4 +16,15 @@ extern double FC_LocalSimple_mean3_stderr(const double y[], const int size);
 extern double FC_LocalSimple_cam(const double y[], const int size, int trainLength);
 extern double FC_LoopLocalSimple_mean_stderr_chn(const double y[], const int size);
 
+extern double FC_LocalSimple_mean_tauresrat_ctx(feature_context * ctx, const int train_length);
+extern double FC_LocalSimple_mean1_tauresrat_ctx(feature_context * ctx);
+extern double FC_LocalSimple_mean_stderr_ctx(feature_context * ctx, const int train_length);
+extern double FC_LocalSimple_mean3_stderr_ctx(feature_context * ctx);
+extern double FC_LoopLocalSimple_mean_stderr_chn_ctx(feature_context * ctx);
+// residual std of the local mean forecast for n training lengths from one
+// prefix-sum array and one pass over the series; NaN where a length leaves
+// fewer than two residuals
+extern void FC_LocalSimple_mean_stderr_multi(const double y[], const int size, const int train_lengths[], const int n, double out[]);
+extern void FC_LocalSimple_mean_stderr_multi_ctx(feature_context * ctx, const int train_lengths[], const int n, double out[]);
+
 #endif
@@ -11,17 +11,16 @@
 #include "CO_AutoCorr.h"
 #include "stats.h"
 
-double IN_AutoMutualInfoStats_40_gaussian_fmmi(const double y[], const int size)
+double IN_AutoMutualInfoStats_40_gaussian_fmmi_ctx(feature_context * ctx)
 {
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
+        return NAN;
     }
 
+    const int size = ctx->size;
+
     // maximum time delay
     int tau = 40;
 
@@ -30,10 +29,43 @@ double IN_AutoMutualInfoStats_40_gaussian_fmmi(const double y[], const int size)
         tau = ceil((double)size/2);
     }
 
+    // Pearson correlation of the overlapping parts y[0..size-lag) and
+    // y[lag..size) for every lag, as autocorr_lag(y, size, lag) computes it.
+    // Lagged products are shared with the context's autocorrelation; the
+    // overlap means and variances follow from the sums of the few samples
+    // that drop out at either end.
+    const double * c = context_centered(ctx);
+    double sum = 0, sumSq = 0;
+    for(int i = 0; i < size; i++){
+        sum += c[i];
+        sumSq += c[i]*c[i];
+    }
+    
+    double headSum = 0, headSq = 0, tailSum = 0, tailSq = 0;
+    
     // compute autocorrelations and compute automutual information
     double * ami = malloc(size * sizeof(double));
     for(int i = 0; i < tau; i++){
-        double ac = autocorr_lag(y,size, i+1);
+        int lag = i+1;
+        int n = size - lag;
+        
+        headSum += c[lag-1];
+        headSq += c[lag-1]*c[lag-1];
+        tailSum += c[size-lag];
+        tailSq += c[size-lag]*c[size-lag];
+        
+        double sumX = sum - tailSum, sumXX = sumSq - tailSq;   // y[0..n)
+        double sumY = sum - headSum, sumYY = sumSq - headSq;   // y[lag..size)
+        
+        double nom = context_lag_product(ctx, lag) - sumX*sumY/n;
+        double denomX = sumXX - sumX*sumX/n;
+        double denomY = sumYY - sumY*sumY/n;
+        
+        double ac = nom/sqrt(denomX * denomY);
+        // the sums can cancel to just past +-1 on exactly periodic input,
+        // where autocorr_lag gives +-1
+        if (ac > 1) ac = 1;
+        if (ac < -1) ac = -1;
         ami[i] = -0.5 * log(1 - ac*ac);
         // printf("ami[%i]=%1.7f\n", i, ami[i]);
     }
@@ -53,31 +85,46 @@ double IN_AutoMutualInfoStats_40_gaussian_fmmi(const double y[], const int size)
     return fmmi;
 }
 
-double IN_AutoMutualInfoStats_diff_20_gaussian_ami8(const double y[], const int size) {
+double IN_AutoMutualInfoStats_40_gaussian_fmmi(const double y[], const int size)
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = IN_AutoMutualInfoStats_40_gaussian_fmmi_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
+
+double IN_AutoMutualInfoStats_diff_20_gaussian_ami8_ctx(feature_context * ctx) {
 
     // NaN check
-    for (int i = 0; i < size; i++)
-        if (isnan(y[i]))
-            return NAN;
-
-        // compute diff(y): length would be size-1 of original vector
-        double *y_diff = (double*) malloc( (size-1)*sizeof(double) );
-        diff(y, size, y_diff);
-        int diff_size = size-1;
-
-        // maximum time delay
-        int tau = 20;
-
-        // don't go above half the signal length
-        if (tau > ceil((double)diff_size/2))
-            tau = ceil((double)diff_size/2);
-
-        // calculate auto mutual information
-        double ac = autocorr_lag(y_diff, diff_size, 8);
-        double ami8 = -0.5 * log(1 - ac*ac);
-
-        if (tau >= 7)
-            return ami8;
-        else
-            return NAN;
+    if (context_has_nan(ctx))
+        return NAN;
+
+    // diff(y): length is size-1 of original vector
+    const double *y_diff = context_diff(ctx);
+    int diff_size = ctx->size-1;
+
+    // maximum time delay
+    int tau = 20;
+
+    // don't go above half the signal length
+    if (tau > ceil((double)diff_size/2))
+        tau = ceil((double)diff_size/2);
+
+    // calculate auto mutual information
+    double ac = autocorr_lag(y_diff, diff_size, 8);
+    double ami8 = -0.5 * log(1 - ac*ac);
+
+    if (tau >= 7)
+        return ami8;
+    else
+        return NAN;
+}
+
+double IN_AutoMutualInfoStats_diff_20_gaussian_ami8(const double y[], const int size) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = IN_AutoMutualInfoStats_diff_20_gaussian_ami8_ctx(&ctx);
+    context_free(&ctx);
+    return out;
 }
@@ -10,8 +10,11 @@
 #define IN_AutoMutualInfoStats_h
 
 #include <stdio.h>
+#include "feature_context.h"
 
 extern double IN_AutoMutualInfoStats_40_gaussian_fmmi(const double y[], const int size);
 extern double IN_AutoMutualInfoStats_diff_20_gaussian_ami8(const double y[], const int size);
+extern double IN_AutoMutualInfoStats_40_gaussian_fmmi_ctx(feature_context * ctx);
+extern double IN_AutoMutualInfoStats_diff_20_gaussian_ami8_ctx(feature_context * ctx);
 
 #endif /* IN_AutoMutualInfoStats_h */
@@ -9,22 +9,19 @@
 #include "MD_hrv.h"
 #include "stats.h"
 
-double MD_hrv_classic_pnn40(const double y[], const int size){
+double MD_hrv_classic_pnn40_ctx(feature_context * ctx){
     
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
+        return NAN;
     }
     
+    const int size = ctx->size;
     const int pNNx = 40;
     
-    // compute diff
-    double * Dy = malloc((size-1) * sizeof(double));
-    diff(y, size, Dy);
+    // diff
+    const double * Dy = context_diff(ctx);
     
     double pnn40 = 0;
     for(int i = 0; i < size-1; i++){
@@ -33,8 +30,14 @@ double MD_hrv_classic_pnn40(const double y[], const int size){
         }
     }
     
-    free(Dy);
-    
     return pnn40/(size-1);
 }
 
+double MD_hrv_classic_pnn40(const double y[], const int size){
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = MD_hrv_classic_pnn40_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
+
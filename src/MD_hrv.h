@@ -10,7 +10,9 @@
 #define MD_hrv_h
 
 #include <stdio.h>
+#include "feature_context.h"
 
 extern double MD_hrv_classic_pnn40(const double y[], const int size);
+extern double MD_hrv_classic_pnn40_ctx(feature_context * ctx);
 
 #endif /* MD_hrv_h */
@@ -12,18 +12,19 @@
 #include "PD_PeriodicityWang.h"
 #include "splinefit.h"
 #include "stats.h"
+#include "CO_AutoCorr.h"
 
-int PD_PeriodicityWang_th0_01(const double * y, const int size){
+int PD_PeriodicityWang_th0_01_ctx(feature_context * ctx){
     
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return 0;
-        }
+        return 0;
     }
     
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
+    
     const double th = 0.01;
     
     double * ySpline = malloc(size * sizeof(double));
@@ -43,12 +44,10 @@ int PD_PeriodicityWang_th0_01(const double * y, const int size){
     // compute autocorrelations up to 1/3 of the length of the time series
     int acmax = (int)ceil((double)size/3);
     
-    double * acf = malloc(acmax*sizeof(double));
-    for(int tau = 1; tau <= acmax; tau++){
-        // correlation/ covariance the same, don't care for scaling (cov would be more efficient)
-        acf[tau-1] = autocov_lag(ySub, size, tau);
-        //printf("acf[%i] = %1.9f\n", tau-1, acf[tau-1]);
-    }
+    // correlation/ covariance the same, don't care for scaling (cov would be more efficient);
+    // all lags at once through the FFT, acf[tau-1] = autocov_lag(ySub, size, tau)
+    double * autocovs = co_autocov_lags(ySub, size, acmax);
+    double * acf = autocovs + 1;
     
     //printf("ACF computed.\n");
     
@@ -128,10 +127,18 @@ int PD_PeriodicityWang_th0_01(const double * y, const int size){
     
     free(ySpline);
     free(ySub);
-    free(acf);
+    free(autocovs);
     free(troughs);
     free(peaks);
     
     return out;
     
 }
+
+int PD_PeriodicityWang_th0_01(const double * y, const int size){
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    int out = PD_PeriodicityWang_th0_01_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
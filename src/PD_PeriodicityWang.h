@@ -10,7 +10,9 @@
 #define PD_PeriodicityWang_h
 
 #include <stdio.h>
+#include "feature_context.h"
 
 extern int PD_PeriodicityWang_th0_01(const double * y, const int size);
+extern int PD_PeriodicityWang_th0_01_ctx(feature_context * ctx);
 
 #endif /* PD_PeriodicityWang_h */
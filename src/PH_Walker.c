@@ -5,14 +5,17 @@
 #include "PH_Walker.h"
 #include "stats.h"
 #include "helper_functions.h"
+#include "feature_context.h"
 
-double PH_Walker_momentum_5_w_momentumzcross(const double y[], const int size) {
+double PH_Walker_momentum_5_w_momentumzcross_ctx(feature_context * ctx) {
     
     // check NAN
     int i;
-    for (i = 0; i < size; i++)
-        if (isnan(y[i]))
-            return NAN;
+    if (context_has_nan(ctx))
+        return NAN;
+    
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
     
     double *w = (double*) malloc(size * sizeof(double));
     double m = 5;
@@ -38,13 +41,15 @@ double PH_Walker_momentum_5_w_momentumzcross(const double y[], const int size) {
     return w_propzcross;
 }
 
-double PH_Walker_biasprop_05_01_sw_meanabsdiff(const double y[], const int size) {
+double PH_Walker_biasprop_05_01_sw_meanabsdiff_ctx(feature_context * ctx) {
     
     // check NAN
     int i;
-    for (i = 0; i < size; i++)
-        if (isnan(y[i]))
-            return NAN;
+    if (context_has_nan(ctx))
+        return NAN;
+    
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
     
     // param = {0.5, 0.1}
     double *w = (double*) malloc(size * sizeof(double));
@@ -68,3 +73,19 @@ double PH_Walker_biasprop_05_01_sw_meanabsdiff(const double y[], const int size)
 
     return sw_meanabsdiff;
 }
+
+double PH_Walker_momentum_5_w_momentumzcross(const double y[], const int size) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = PH_Walker_momentum_5_w_momentumzcross_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
+
+double PH_Walker_biasprop_05_01_sw_meanabsdiff(const double y[], const int size) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = PH_Walker_biasprop_05_01_sw_meanabsdiff_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
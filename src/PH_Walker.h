@@ -1,7 +1,11 @@
 #ifndef PH_WALKER_H
 #define PH_WALKER_H
 
+#include "feature_context.h"
+
 extern double PH_Walker_momentum_5_w_momentumzcross(const double y[], const int size);
 extern double PH_Walker_biasprop_05_01_sw_meanabsdiff(const double y[], const int size);
+extern double PH_Walker_momentum_5_w_momentumzcross_ctx(feature_context * ctx);
+extern double PH_Walker_biasprop_05_01_sw_meanabsdiff_ctx(feature_context * ctx);
 
 #endif
@@ -424,6 +424,78 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// catch_features
+NumericVector catch_features(NumericVector x, std::string featureSet, int nThreads);
+RcppExport SEXP _catchEmAll_catch_features(SEXP xSEXP, SEXP featureSetSEXP, SEXP nThreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< std::string >::type featureSet(featureSetSEXP);
+    Rcpp::traits::input_parameter< int >::type nThreads(nThreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(catch_features(x, featureSet, nThreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// CO_HistogramAMI_even_multi
+NumericVector CO_HistogramAMI_even_multi(NumericVector x, IntegerVector numBins, IntegerVector tau);
+RcppExport SEXP _catchEmAll_CO_HistogramAMI_even_multi(SEXP xSEXP, SEXP numBinsSEXP, SEXP tauSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type numBins(numBinsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type tau(tauSEXP);
+    rcpp_result_gen = Rcpp::wrap(CO_HistogramAMI_even_multi(x, numBins, tau));
+    return rcpp_result_gen;
+END_RCPP
+}
+// CO_AddNoise_1_even_10_ami_curve
+NumericVector CO_AddNoise_1_even_10_ami_curve(NumericVector x);
+RcppExport SEXP _catchEmAll_CO_AddNoise_1_even_10_ami_curve(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(CO_AddNoise_1_even_10_ami_curve(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// DN_HistogramMode_multi
+NumericVector DN_HistogramMode_multi(NumericVector x, IntegerVector nBins);
+RcppExport SEXP _catchEmAll_DN_HistogramMode_multi(SEXP xSEXP, SEXP nBinsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type nBins(nBinsSEXP);
+    rcpp_result_gen = Rcpp::wrap(DN_HistogramMode_multi(x, nBins));
+    return rcpp_result_gen;
+END_RCPP
+}
+// SP_Summaries_welch_rect_entropy
+NumericVector SP_Summaries_welch_rect_entropy(NumericVector x);
+RcppExport SEXP _catchEmAll_SP_Summaries_welch_rect_entropy(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(SP_Summaries_welch_rect_entropy(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// SP_Summaries_welch_rect_bandpowers
+NumericVector SP_Summaries_welch_rect_bandpowers(NumericVector x, int nBands);
+RcppExport SEXP _catchEmAll_SP_Summaries_welch_rect_bandpowers(SEXP xSEXP, SEXP nBandsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type nBands(nBandsSEXP);
+    rcpp_result_gen = Rcpp::wrap(SP_Summaries_welch_rect_bandpowers(x, nBands));
+    return rcpp_result_gen;
+END_RCPP
+}
 // minmax_scaler
 NumericVector minmax_scaler(NumericVector x);
 RcppExport SEXP _catchEmAll_minmax_scaler(SEXP xSEXP) {
@@ -479,6 +551,19 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// catch_features_batch
+NumericMatrix catch_features_batch(SEXP data, std::string featureSet, int nThreads);
+RcppExport SEXP _catchEmAll_catch_features_batch(SEXP dataSEXP, SEXP featureSetSEXP, SEXP nThreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type data(dataSEXP);
+    Rcpp::traits::input_parameter< std::string >::type featureSet(featureSetSEXP);
+    Rcpp::traits::input_parameter< int >::type nThreads(nThreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(catch_features_batch(data, featureSet, nThreads));
+    return rcpp_result_gen;
+END_RCPP
+}
 
 static const R_CallMethodDef CallEntries[] = {
     {"_catchEmAll_DN_HistogramMode_5", (DL_FUNC) &_catchEmAll_DN_HistogramMode_5, 1},
@@ -519,11 +604,18 @@ static const R_CallMethodDef CallEntries[] = {
     {"_catchEmAll_PH_Walker_biasprop_05_01_sw_meanabsdiff", (DL_FUNC) &_catchEmAll_PH_Walker_biasprop_05_01_sw_meanabsdiff, 1},
     {"_catchEmAll_ST_LocalExtrema_n100_diffmaxabsmin", (DL_FUNC) &_catchEmAll_ST_LocalExtrema_n100_diffmaxabsmin, 1},
     {"_catchEmAll_SC_FluctAnal_2_dfa_50_2_logi_r2_se2", (DL_FUNC) &_catchEmAll_SC_FluctAnal_2_dfa_50_2_logi_r2_se2, 1},
+    {"_catchEmAll_catch_features", (DL_FUNC) &_catchEmAll_catch_features, 3},
+    {"_catchEmAll_CO_HistogramAMI_even_multi", (DL_FUNC) &_catchEmAll_CO_HistogramAMI_even_multi, 3},
+    {"_catchEmAll_CO_AddNoise_1_even_10_ami_curve", (DL_FUNC) &_catchEmAll_CO_AddNoise_1_even_10_ami_curve, 1},
+    {"_catchEmAll_DN_HistogramMode_multi", (DL_FUNC) &_catchEmAll_DN_HistogramMode_multi, 2},
+    {"_catchEmAll_SP_Summaries_welch_rect_entropy", (DL_FUNC) &_catchEmAll_SP_Summaries_welch_rect_entropy, 1},
+    {"_catchEmAll_SP_Summaries_welch_rect_bandpowers", (DL_FUNC) &_catchEmAll_SP_Summaries_welch_rect_bandpowers, 2},
     {"_catchEmAll_minmax_scaler", (DL_FUNC) &_catchEmAll_minmax_scaler, 1},
     {"_catchEmAll_zscore_scaler", (DL_FUNC) &_catchEmAll_zscore_scaler, 1},
     {"_catchEmAll_sigmoid_scaler", (DL_FUNC) &_catchEmAll_sigmoid_scaler, 1},
     {"_catchEmAll_robustsigmoid_scaler", (DL_FUNC) &_catchEmAll_robustsigmoid_scaler, 1},
     {"_catchEmAll_mean_scaler", (DL_FUNC) &_catchEmAll_mean_scaler, 1},
+    {"_catchEmAll_catch_features_batch", (DL_FUNC) &_catchEmAll_catch_features_batch, 3},
     {NULL, NULL, 0}
 };
 
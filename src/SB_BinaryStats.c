@@ -9,22 +9,22 @@
 #include "SB_BinaryStats.h"
 #include "stats.h"
 
-double SB_BinaryStats_diff_longstretch0(const double y[], const int size){
+double SB_BinaryStats_diff_longstretch0_ctx(feature_context * ctx){
     
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
+        return NAN;
     }
     
+    const int size = ctx->size;
+    const double * yDiff = context_diff(ctx);
+    
     // binarize
     int * yBin = malloc((size-1) * sizeof(int));
     for(int i = 0; i < size-1; i++){
         
-        double diffTemp = y[i+1] - y[i];
+        double diffTemp = yDiff[i];
         yBin[i] = diffTemp < 0 ? 0 : 1;
         
         /*
@@ -51,20 +51,28 @@ double SB_BinaryStats_diff_longstretch0(const double y[], const int size){
     return maxstretch0;
 }
 
-double SB_BinaryStats_mean_longstretch1(const double y[], const int size){
+double SB_BinaryStats_diff_longstretch0(const double y[], const int size){
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = SB_BinaryStats_diff_longstretch0_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
+
+double SB_BinaryStats_mean_longstretch1_ctx(feature_context * ctx){
     
     // NaN check
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
+        return NAN;
     }
     
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
+    
     // binarize
     int * yBin = malloc((size-1) * sizeof(int));
-    double yMean = mean(y, size);
+    double yMean = context_mean(ctx);
     for(int i = 0; i < size-1; i++){
         
         yBin[i] = (y[i] - yMean <= 0) ? 0 : 1;
@@ -89,3 +97,11 @@ double SB_BinaryStats_mean_longstretch1(const double y[], const int size){
     
     return maxstretch1;
 }
+
+double SB_BinaryStats_mean_longstretch1(const double y[], const int size){
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = SB_BinaryStats_mean_longstretch1_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
@@ -10,8 +10,11 @@
 #define SB_BinaryStats_h
 
 #include <stdio.h>
+#include "feature_context.h"
 
 extern double SB_BinaryStats_diff_longstretch0(const double y[], const int size);
 extern double SB_BinaryStats_mean_longstretch1(const double y[], const int size);
+extern double SB_BinaryStats_diff_longstretch0_ctx(feature_context * ctx);
+extern double SB_BinaryStats_mean_longstretch1_ctx(feature_context * ctx);
 
 #endif /* SB_BinaryStats_h */
@@ -4,10 +4,24 @@
 #include <stdio.h>
 #include "stats.h"
 #include "helper_functions.h"
+#include "SB_CoarseGrain.h"
+
+// One pass over the samples; a sample gets the last group whose interval
+// (th[i], th[i+1]] holds it, 0 if there is none
+static void sb_coarsegrain_labels(const double y[], const int size, const double th[], const int num_groups, int labels[])
+{
+    for (int j = 0; j < size; j++) {
+        int label = 0;
+        for (int i = 0; i < num_groups; i++) {
+            int in = (y[j] > th[i]) & (y[j] <= th[i + 1]);
+            label = in ? i + 1 : label;
+        }
+        labels[j] = label;
+    }
+}
 
 void sb_coarsegrain(const double y[], const int size, const char how[], const int num_groups, int labels[])
 {
-    int i, j;
     if (strcmp(how, "quantile") == 1) {
         fprintf(stdout, "ERROR in sb_coarsegrain: unknown coarse-graining method\n");
         exit(1);
@@ -19,22 +33,28 @@ void sb_coarsegrain(const double y[], const int size, const char how[], const in
     }
     */
     
-    double * th = malloc((num_groups + 1) * 2 * sizeof(th));
-    double * ls = malloc((num_groups + 1) * 2 * sizeof(th));
+    // all thresholds from one multi-quantile selection
+    double th[num_groups + 1];
+    double ls[num_groups + 1];
+    linspace(0, 1, num_groups + 1, ls);
+    quantiles(y, size, ls, num_groups + 1, th);
+    th[0] -= 1;
+    
+    sb_coarsegrain_labels(y, size, th, num_groups, labels);
+}
+
+// quantile coarse-graining with the thresholds read off an ascending copy of y
+void sb_coarsegrain_sorted(const double y[], const double sorted[], const int size, const int num_groups, int labels[])
+{
+    int i;
+    
+    double th[num_groups + 1];
+    double ls[num_groups + 1];
     linspace(0, 1, num_groups + 1, ls);
     for (i = 0; i < num_groups + 1; i++) {
-        //double quant = quantile(y, size, ls[i]);
-        th[i] = quantile(y, size, ls[i]);
+        th[i] = quantile_sorted(sorted, size, ls[i]);
     }
     th[0] -= 1;
-    for (i = 0; i < num_groups; i++) {
-        for (j = 0; j < size; j++) {
-            if (y[j] > th[i] && y[j] <= th[i + 1]) {
-                labels[j] = i + 1;
-            }
-        }
-    }
     
-    free(th);
-    free(ls);
+    sb_coarsegrain_labels(y, size, th, num_groups, labels);
 }
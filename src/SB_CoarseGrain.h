@@ -8,5 +8,6 @@
 #include "helper_functions.h"
 
 extern void sb_coarsegrain(const double y[], const int size, const char how[], const int num_groups, int labels[]);
+extern void sb_coarsegrain_sorted(const double y[], const double sorted[], const int size, const int num_groups, int labels[]);
 
 #endif
@@ -5,8 +5,29 @@
 #include <stdlib.h>
 #include "SB_CoarseGrain.h"
 #include "helper_functions.h"
+#include "feature_context.h"
 
 extern double SB_MotifThree_quantile_hh(const double y[], const int size);
+extern double SB_MotifThree_quantile_hh_ctx(feature_context * ctx);
 extern double * sb_motifthree(const double y[], int size, const char how[]);
 
+// longest word sb_motif_counts handles
+#define SB_MOTIF_MAX_LENGTH 4
+
+// Counts of all words of length 1..maxLength over labels 1..alphabetSize,
+// from one pass over the labels. Block k (after the blocks of the shorter
+// lengths) has alphabetSize^k entries; word a_1..a_k is at
+// sum (a_i - 1) alphabetSize^(k-i). Words containing labels outside
+// 1..alphabetSize are not counted. Nothing is written unless alphabetSize >= 1,
+// 1 <= maxLength <= SB_MOTIF_MAX_LENGTH and alphabetSize^(maxLength+1) fits
+// in an int (alphabetSize <= 73 for maxLength 4).
+extern void sb_motif_counts(const int labels[], const int size, const int alphabetSize, const int maxLength, int counts[]);
+// entries of the counts table, sum of alphabetSize^k over k = 1..maxLength
+// (0 where sb_motif_counts would not count)
+extern int sb_motif_counts_size(const int alphabetSize, const int maxLength);
+// for every length k = 1..maxLength the word probabilities, followed by
+// their entropy (sb_motif_counts_size + maxLength entries in total); the
+// same bounds as for sb_motif_counts apply
+extern void sb_motif_stats(const int labels[], const int size, const int alphabetSize, const int maxLength, double out[]);
+
 #endif
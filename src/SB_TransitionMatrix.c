@@ -10,29 +10,23 @@
 #include "CO_AutoCorr.h"
 #include "SB_CoarseGrain.h"
 #include "stats.h"
+#include "feature_context.h"
 
-double SB_TransitionMatrix_3ac_sumdiagcov(const double y[], const int size)
+double SB_TransitionMatrix_3ac_sumdiagcov_ctx(feature_context * ctx)
 {
     
     // NaN and const check
-    int constant = 1;
-    for(int i = 0; i < size; i++)
+    if(context_has_nan(ctx) || context_min(ctx) == context_max(ctx))
     {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
-        if(y[i] != y[0]){
-            constant = 0;
-        }
-    }
-    if (constant){
         return NAN;
     }
     
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
+    
     const int numGroups = 3;
     
-    int tau = co_firstzero(y, size, size);
+    int tau = context_firstzero(ctx);
     
     double * yFilt = malloc(size * sizeof(double));
     
@@ -69,7 +63,13 @@ double SB_TransitionMatrix_3ac_sumdiagcov(const double y[], const int size)
     
     // transfer to alphabet
     int * yCG = malloc(nDown * sizeof(double));
-    sb_coarsegrain(yDown, nDown, "quantile", numGroups, yCG);
+    if(tau == 1){
+        // not downsampled: the thresholds come from the shared sorted series
+        sb_coarsegrain_sorted(yDown, context_sorted(ctx), nDown, numGroups, yCG);
+    }
+    else{
+        sb_coarsegrain(yDown, nDown, "quantile", numGroups, yCG);
+    }
     
     /*
     for(int i = 0; i < nDown; i++){
@@ -161,3 +161,12 @@ double SB_TransitionMatrix_3ac_sumdiagcov(const double y[], const int size)
     
     
 }
+
+double SB_TransitionMatrix_3ac_sumdiagcov(const double y[], const int size)
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = SB_TransitionMatrix_3ac_sumdiagcov_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
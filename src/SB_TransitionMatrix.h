@@ -9,7 +9,9 @@
 #define SB_TransitionMatrix_h
 
 #include <stdio.h>
+#include "feature_context.h"
 
 extern double SB_TransitionMatrix_3ac_sumdiagcov(const double y[], const int size);
+extern double SB_TransitionMatrix_3ac_sumdiagcov_ctx(feature_context * ctx);
 
 #endif /* SB_TransitionMatrix_h */
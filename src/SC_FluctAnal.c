@@ -6,199 +6,481 @@
 #include "stats.h"
 #include "CO_AutoCorr.h"
 #include "SC_FluctAnal.h"
+#include "feature_context.h"
 
 #include <gsl/gsl_multifit.h>
 #include <gsl/gsl_randist.h>
 
-double SC_FluctAnal_2_50_1_logi_prop_r1(const double y[], const int size, const int lag, const char how[])
+// Windowed sums for closed-form detrending come from differences of prefix
+// sums over the whole series. The cumulative sums are large compared with
+// the residuals inside short windows, so the prefix sums are carried in
+// double-double precision (an unevaluated sum hi + lo), as is the closed
+// form for each window.
+typedef struct fluct_dd {
+    double hi, lo;
+} fluct_dd;
+
+static fluct_dd dd_two_sum(const double a, const double b)
 {
-    // NaN check
-    for(int i = 0; i < size; i++)
-    {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
-    }
+    fluct_dd r;
+    r.hi = a + b;
+    double bb = r.hi - a;
+    r.lo = (a - (r.hi - bb)) + (b - bb);
+    return r;
+}
 
-    // generate log spaced tau vector
-    double linLow = log(5);
-    double linHigh = log(size/2);
+static fluct_dd dd_add(const fluct_dd a, const fluct_dd b)
+{
+    fluct_dd r = dd_two_sum(a.hi, b.hi);
+    r.lo += a.lo + b.lo;
+    return dd_two_sum(r.hi, r.lo);
+}
 
-    int nTauSteps = 50;
-    double tauStep = (linHigh - linLow) / (nTauSteps-1);
+static fluct_dd dd_sub(const fluct_dd a, const fluct_dd b)
+{
+    fluct_dd nb = {-b.hi, -b.lo};
+    return dd_add(a, nb);
+}
 
-    int tau[50];
-    for(int i = 0; i < nTauSteps; i++)
+// exact product of two doubles (Dekker), no fma needed
+static fluct_dd dd_two_prod(const double a, const double b)
+{
+    const double split = 134217729.0; // 2^27 + 1
+    double ca = split * a, cb = split * b;
+    double ah = ca - (ca - a), al = a - ah;
+    double bh = cb - (cb - b), bl = b - bh;
+    fluct_dd r;
+    r.hi = a * b;
+    r.lo = ((ah * bh - r.hi) + ah * bl + al * bh) + al * bl;
+    return r;
+}
+
+static fluct_dd dd_mul(const fluct_dd a, const double b)
+{
+    fluct_dd r = dd_two_prod(a.hi, b);
+    r.lo += a.lo * b;
+    return dd_two_sum(r.hi, r.lo);
+}
+
+static fluct_dd dd_mul_dd(const fluct_dd a, const fluct_dd b)
+{
+    fluct_dd r = dd_two_prod(a.hi, b.hi);
+    r.lo += a.hi * b.lo + a.lo * b.hi;
+    return dd_two_sum(r.hi, r.lo);
+}
+
+static fluct_dd dd_div(const fluct_dd a, const fluct_dd b)
+{
+    double q1 = a.hi / b.hi;
+    fluct_dd r = dd_sub(a, dd_mul(b, q1));
+    return dd_two_sum(q1, r.hi / b.hi);
+}
+
+// Prefix moments of a series x: m0[i], m1[i] and m2[i] hold the sums over
+// t < i of x[t], t * x[t] and x[t]^2.
+static void fluct_prefix_moments(const double x[], const int size, fluct_dd m0[], fluct_dd m1[], fluct_dd m2[])
+{
+    fluct_dd zero = {0.0, 0.0};
+    m0[0] = m1[0] = m2[0] = zero;
+    for(int t = 0; t < size; t++)
     {
-        tau[i] = round(exp(linLow + i*tauStep));
+        fluct_dd v = {x[t], 0.0};
+        m0[t+1] = dd_add(m0[t], v);
+        m1[t+1] = dd_add(m1[t], dd_two_prod(t, x[t]));
+        m2[t+1] = dd_add(m2[t], dd_two_prod(x[t], x[t]));
     }
+}
 
-    // check for uniqueness, use ascending order
-    int nTau = nTauSteps;
-    for(int i = 0; i < nTauSteps-1; i++)
+// m3[i] = sum over t < i of t^2 * x[t], for quadratic detrending
+static void fluct_prefix_moment_t2(const double x[], const int size, fluct_dd m3[])
+{
+    m3[0].hi = m3[0].lo = 0.0;
+    for(int t = 0; t < size; t++)
     {
-
-        while (tau[i] == tau[i+1] && i < nTau-1)
-        {
-            for(int j = i+1; j < nTauSteps-1; j++)
-            {
-                tau[j] = tau[j+1];
-            }
-            // lost one
-            nTau -= 1;
-        }
+        m3[t+1] = dd_add(m3[t], dd_two_prod((double)t*t, x[t]));
     }
+}
 
-    // fewer than 12 points -> leave.
-    if(nTau < 12){
-        return 0;
-    }
+// Constants of the centred window index u = k - (n-1)/2, k = 0..n-1, shared
+// by all windows of a scale: sum u^2 = n (n^2 - 1) / 12 and the reciprocals
+// of n, sum u^2 and sum q^2 = n (n^2 - 1) (n^2 - 4) / 180, q = u^2 - mean(u^2).
+typedef struct fluct_window {
+    int n;
+    fluct_dd suu;
+    fluct_dd invN, invSuu, invSqq;
+} fluct_window;
 
-    int sizeCS = size/lag;
-    double * yCS = malloc(sizeCS * sizeof(double));
+static fluct_window fluct_window_init(const int n)
+{
+    fluct_window win;
+    fluct_dd one = {1.0, 0.0};
+    fluct_dd twelve = {12.0, 0.0};
+    fluct_dd fifteen = {15.0, 0.0};
+    fluct_dd nd = {n, 0.0};
+
+    win.n = n;
+    win.suu = dd_div(dd_mul(dd_two_prod(n-1, n+1), n), twelve);
+    win.invN = dd_div(one, nd);
+    win.invSuu = dd_div(one, win.suu);
+    win.invSqq = dd_div(fifteen, dd_mul_dd(win.suu, dd_two_prod(n-2, n+2)));
+    return win;
+}
 
-    /*
-    for(int i = 0; i < 50; i++)
-    {
-        printf("y[%i]=%1.3f\n", i, y[i]);
+// Sums over the window x[start .. start+n-1] of w = x - x[start], w^2, u * w
+// and u^2 * w. The shift by x[start] leaves the detrended residuals unchanged
+// but keeps the sums small. suuw is only filled in if m3 is given.
+static void fluct_window_sums(const double x[], const fluct_dd m0[], const fluct_dd m1[], const fluct_dd m2[],
+                              const fluct_dd m3[], const fluct_window * win, const int start,
+                              fluct_dd * sw, fluct_dd * sww, fluct_dd * suw, fluct_dd * suuw)
+{
+    int n = win->n;
+    int end = start + n;
+    double a = x[start];
+    double c = start + 0.5*(n-1);
+    fluct_dd sy = dd_sub(m0[end], m0[start]);
+    fluct_dd syy = dd_sub(m2[end], m2[start]);
+    fluct_dd sty = dd_sub(m1[end], m1[start]);
+
+    *sw = dd_sub(sy, dd_two_prod(n, a));
+    *sww = dd_add(dd_sub(syy, dd_mul(sy, 2*a)), dd_mul(dd_two_prod(a, a), n));
+    // sum u y = sum t y - c sum y, and sum u = 0
+    *suw = dd_sub(sty, dd_mul(sy, c));
+    if (m3 != NULL) {
+        // sum u^2 y = sum t^2 y - 2 c sum t y + c^2 sum y
+        fluct_dd stty = dd_sub(m3[end], m3[start]);
+        fluct_dd suuy = dd_add(dd_sub(stty, dd_mul(sty, 2*c)), dd_mul(dd_mul(sy, c), c));
+        *suuw = dd_sub(suuy, dd_mul(win->suu, a));
     }
-     */
+}
 
-    // transform input vector to cumsum
-    yCS[0] = y[0];
-    for(int i = 0; i < sizeCS-1; i++)
-    {
-        yCS[i+1] = yCS[i] + y[(i+1)*lag];
+// residual sum of squares of the least-squares line through the window
+// x[start .. start+n-1], from the prefix moments
+static double fluct_rss_linear(const double x[], const fluct_dd m0[], const fluct_dd m1[], const fluct_dd m2[],
+                               const fluct_window * win, const int start)
+{
+    fluct_dd sw, sww, suw;
+    fluct_window_sums(x, m0, m1, m2, NULL, win, start, &sw, &sww, &suw, NULL);
 
-        /*
-        if(i<300)
-            printf("yCS[%i]=%1.3f\n", i, yCS[i]);
-         */
-    }
+    fluct_dd rss = dd_sub(sww, dd_mul_dd(dd_mul_dd(sw, sw), win->invN));
+    rss = dd_sub(rss, dd_mul_dd(dd_mul_dd(suw, suw), win->invSuu));
+    return rss.hi < 0 ? 0.0 : rss.hi;
+}
 
-    //for each value of tau, cut signal into snippets of length tau, detrend and
+// residual sum of squares of the least-squares quadratic through the window.
+// The fit is expanded in polynomials that are orthogonal over the window
+// (1, u, q), so each one removes its own share of the sum of squares.
+static double fluct_rss_quadratic(const double x[], const fluct_dd m0[], const fluct_dd m1[], const fluct_dd m2[],
+                                  const fluct_dd m3[], const fluct_window * win, const int start)
+{
+    fluct_dd sw, sww, suw, suuw;
+    fluct_window_sums(x, m0, m1, m2, m3, win, start, &sw, &sww, &suw, &suuw);
 
-    // first generate a support for regression (detrending)
-    double * xReg = malloc(tau[nTau-1] * sizeof * xReg);
-    for(int i = 0; i < tau[nTau-1]; i++)
-    {
-        xReg[i] = i+1;
-    }
+    // sum q w
+    fluct_dd sqw = dd_sub(suuw, dd_mul_dd(dd_mul_dd(win->suu, sw), win->invN));
 
-    // iterate over taus, cut signal, detrend and save amplitude of remaining signal
-    double * F = malloc(nTau * sizeof * F);
-    for(int i = 0; i < nTau; i++)
+    fluct_dd rss = dd_sub(sww, dd_mul_dd(dd_mul_dd(sw, sw), win->invN));
+    rss = dd_sub(rss, dd_mul_dd(dd_mul_dd(suw, suw), win->invSuu));
+    rss = dd_sub(rss, dd_mul_dd(dd_mul_dd(sqw, sqw), win->invSqq));
+    return rss.hi < 0 ? 0.0 : rss.hi;
+}
+
+// range (max - min) of the residuals of the least-squares line through the
+// window x[start .. start+n-1]. The slope comes from the prefix moments; the
+// residuals are streamed once for their extremes and never stored. The
+// intercept shifts all residuals alike, so it is left out.
+static double fluct_range_linear(const double x[], const fluct_dd m0[], const fluct_dd m1[],
+                                 const fluct_window * win, const int start)
+{
+    int n = win->n;
+    int end = start + n;
+    double c = start + 0.5*(n-1);
+    fluct_dd sy = dd_sub(m0[end], m0[start]);
+    // sum u x, u the index centred on the window
+    fluct_dd suy = dd_sub(dd_sub(m1[end], m1[start]), dd_mul(sy, c));
+    double slope = dd_mul_dd(suy, win->invSuu).hi;
+
+    const double * w = x + start;
+    double a = w[0];
+    double hi = 0.0, lo = 0.0;
+#ifdef _OPENMP
+#pragma omp simd reduction(max:hi) reduction(min:lo)
+#endif
+    for(int k = 1; k < n; k++)
     {
-        int nBuffer = sizeCS/tau[i];
-        double * buffer = malloc(tau[i] * sizeof * buffer);
-        double m = 0.0, b = 0.0;
+        double r = (w[k] - a) - slope * k;
+        hi = r > hi ? r : hi;
+        lo = r < lo ? r : lo;
+    }
+    return hi - lo;
+}
 
-        //printf("tau[%i]=%i\n", i, tau[i]);
+// The three SC_FluctAnal features share one log-spaced tau grid, and the
+// lag-1 cumulative sum and its prefix moments. Everything is computed once
+// per series and kept in the feature context.
+#define FLUCT_NTAU_STEPS 50
+// subsampling lags whose cumulative sums are kept in the context
+#define FLUCT_MAX_LAG 2
+// series at least this long get their rsrangefit scales spread over the
+// context's threads (ctx->nThreads, 1 unless the caller raises it)
+#define FLUCT_PARALLEL_SIZE 32768
+
+enum { FLUCT_DFA_1, FLUCT_DFA_2, FLUCT_RSRANGE, FLUCT_NMODES };
+
+// cumulative sum of y[0], y[lag], y[2 lag], ... with its prefix moments;
+// m[3] is only built once quadratic detrending is asked for
+typedef struct fluct_series {
+    int size;
+    const double * yCS;
+    double * yCSOwned;
+    fluct_dd * m[4];
+} fluct_series;
+
+struct fluct_analysis {
+    int nTau;
+    int tau[FLUCT_NTAU_STEPS];
+    double logtt[FLUCT_NTAU_STEPS];
+    fluct_series series[FLUCT_MAX_LAG];
+    int haveLogF[FLUCT_MAX_LAG][FLUCT_NMODES];
+    double logF[FLUCT_MAX_LAG][FLUCT_NMODES][FLUCT_NTAU_STEPS];
+};
+
+static void fluct_series_free(fluct_series * fs)
+{
+    free(fs->yCSOwned);
+    free(fs->m[0]);
+    free(fs->m[3]);
+    memset(fs, 0, sizeof * fs);
+}
 
-        F[i] = 0;
-        for(int j = 0; j < nBuffer; j++)
-        {
+void fluct_analysis_free(fluct_analysis * fa)
+{
+    if (fa == NULL) {
+        return;
+    }
+    for (int l = 0; l < FLUCT_MAX_LAG; l++) {
+        fluct_series_free(&fa->series[l]);
+    }
+    free(fa);
+}
 
-            //printf("%i th buffer\n", j);
+static fluct_analysis * context_fluct(feature_context * ctx)
+{
+    if (ctx->fluct != NULL) {
+        return ctx->fluct;
+    }
+    fluct_analysis * fa = calloc(1, sizeof * fa);
 
-            linreg(tau[i], xReg, yCS+j*tau[i], &m, &b);
+    // generate log spaced tau vector
+    double linLow = log(5);
+    double linHigh = log(ctx->size/2);
+    double tauStep = (linHigh - linLow) / (FLUCT_NTAU_STEPS-1);
+
+    // keep unique values only; the grid is ascending
+    fa->nTau = 0;
+    for (int i = 0; i < FLUCT_NTAU_STEPS; i++) {
+        int t = round(exp(linLow + i*tauStep));
+        if (fa->nTau == 0 || t != fa->tau[fa->nTau-1]) {
+            fa->tau[fa->nTau++] = t;
+        }
+    }
+    for (int i = 0; i < fa->nTau; i++) {
+        fa->logtt[i] = log(fa->tau[i]);
+    }
 
+    ctx->fluct = fa;
+    return fa;
+}
 
-            for(int k = 0; k < tau[i]; k++)
-            {
-                buffer[k] = yCS[j*tau[i]+k] - (m * (k+1) + b);
-                //printf("buffer[%i]=%1.3f\n", k, buffer[k]);
+// cumulative sum for a lag, with the prefix moments needed by mode
+static void fluct_series_prepare(feature_context * ctx, fluct_series * fs, const int lag, const int mode)
+{
+    if (fs->yCS == NULL) {
+        fs->size = ctx->size/lag;
+        if (lag == 1) {
+            fs->yCS = context_cumsum(ctx);
+        }
+        else {
+            const double * y = context_y(ctx);
+            fs->yCSOwned = malloc(fs->size * sizeof(double));
+            fs->yCSOwned[0] = y[0];
+            for (int i = 0; i < fs->size-1; i++) {
+                fs->yCSOwned[i+1] = fs->yCSOwned[i] + y[(i+1)*lag];
             }
+            fs->yCS = fs->yCSOwned;
+        }
+    }
+    if (fs->m[0] == NULL) {
+        fs->m[0] = malloc(3 * (fs->size+1) * sizeof(fluct_dd));
+        fs->m[1] = fs->m[0] + (fs->size+1);
+        fs->m[2] = fs->m[1] + (fs->size+1);
+        fluct_prefix_moments(fs->yCS, fs->size, fs->m[0], fs->m[1], fs->m[2]);
+    }
+    if (mode == FLUCT_DFA_2 && fs->m[3] == NULL) {
+        fs->m[3] = malloc((fs->size+1) * sizeof(fluct_dd));
+        fluct_prefix_moment_t2(fs->yCS, fs->size, fs->m[3]);
+    }
+}
 
-            if (strcmp(how, "rsrangefit") == 0) {
-                F[i] += pow(max_(buffer, tau[i]) - min_(buffer, tau[i]), 2);
-            }
-            else if (strcmp(how, "dfa") == 0) {
-                for(int k = 0; k<tau[i]; k++){
-                    F[i] += buffer[k]*buffer[k];
-                }
-            }
-            else{
-                return 0.0;
+// log of the fluctuation function at every scale: root mean squared
+// residual (dfa) or root mean squared residual range (rsrangefit) of a
+// detrend over non-overlapping windows of length tau[i]
+static void fluct_compute_logF(const fluct_analysis * fa, const fluct_series * fs, const int mode, const int nThreads, double logF[])
+{
+    const double * yCS = fs->yCS;
+
+    // the range kernel touches every sample at every scale, so on long
+    // series the scales are worth spreading over threads
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads) if(nThreads > 1 && mode == FLUCT_RSRANGE && fs->size >= FLUCT_PARALLEL_SIZE)
+#endif
+    for (int i = 0; i < fa->nTau; i++) {
+        int tau = fa->tau[i];
+        int nBuffer = fs->size/tau;
+        fluct_window win = fluct_window_init(tau);
+        double F = 0;
+
+        if (mode == FLUCT_DFA_1) {
+            for (int j = 0; j < nBuffer; j++) {
+                F += fluct_rss_linear(yCS, fs->m[0], fs->m[1], fs->m[2], &win, j*tau);
             }
+            F = sqrt(F/(nBuffer*tau));
         }
-
-        if (strcmp(how, "rsrangefit") == 0) {
-            F[i] = sqrt(F[i]/nBuffer);
+        else if (mode == FLUCT_DFA_2) {
+            for (int j = 0; j < nBuffer; j++) {
+                F += fluct_rss_quadratic(yCS, fs->m[0], fs->m[1], fs->m[2], fs->m[3], &win, j*tau);
+            }
+            F = sqrt(F/(nBuffer*tau));
         }
-        else if (strcmp(how, "dfa") == 0) {
-            F[i] = sqrt(F[i]/(nBuffer*tau[i]));
+        else {
+            for (int j = 0; j < nBuffer; j++) {
+                double range = fluct_range_linear(yCS, fs->m[0], fs->m[1], &win, j*tau);
+                F += range*range;
+            }
+            F = sqrt(F/nBuffer);
         }
-        //printf("F[%i]=%1.3f\n", i, F[i]);
-
-        free(buffer);
-
+        // Windows of an exactly linear (or quadratic) cumulative sum fit
+        // with no residual at all, where detrending the samples directly
+        // leaves rounding noise of about DBL_EPSILON times their size. Such
+        // scales get that noise level instead of log(0) = -inf.
+        double Fmin = DBL_EPSILON * sqrt(fs->m[2][nBuffer*tau].hi / (nBuffer*tau));
+        logF[i] = log(F < Fmin ? Fmin : F);
     }
+}
 
-    double * logtt = malloc(nTau * sizeof * logtt);
-    double * logFF = malloc(nTau * sizeof * logFF);
-    int ntt = nTau;
-
-    for (int i = 0; i < nTau; i++)
-    {
-        logtt[i] = log(tau[i]);
-        logFF[i] = log(F[i]);
+// log fluctuation function for a lag and mode, from the context if cached
+static void context_fluct_logF(feature_context * ctx, const int lag, const int mode, double logF[])
+{
+    fluct_analysis * fa = context_fluct(ctx);
+    if (lag > FLUCT_MAX_LAG) {
+        fluct_series fs;
+        memset(&fs, 0, sizeof fs);
+        fluct_series_prepare(ctx, &fs, lag, mode);
+        fluct_compute_logF(fa, &fs, mode, ctx->nThreads, logF);
+        fluct_series_free(&fs);
+        return;
     }
+    if (!fa->haveLogF[lag-1][mode]) {
+        fluct_series_prepare(ctx, &fa->series[lag-1], lag, mode);
+        fluct_compute_logF(fa, &fa->series[lag-1], mode, ctx->nThreads, fa->logF[lag-1][mode]);
+        fa->haveLogF[lag-1][mode] = 1;
+    }
+    memcpy(logF, fa->logF[lag-1][mode], fa->nTau * sizeof(double));
+}
 
-    int minPoints = 6;
+// Two-regime fit of logF against logtt: for every split i the points
+// 0..i-1 and i-1..ntt-1 are fitted with separate lines, and the split with
+// the smallest sum of the residual norms is taken (first one on ties).
+// Returns the index of the last point of the first regime. The per-segment
+// least squares come from prefix sums, each split in O(1).
+static int fluct_breakpoint(const double logtt[], const double logFF[], const int ntt)
+{
+    const int minPoints = 6;
     int nsserr = (ntt - 2*minPoints + 1);
-    double * sserr = malloc(nsserr * sizeof * sserr);
-    double * buffer = malloc((ntt - minPoints + 1) * sizeof * buffer);
-    for (int i = minPoints; i < ntt - minPoints + 1; i++)
-    {
-        // this could be done with less variables of course
-        double m1 = 0.0, b1 = 0.0;
-        double m2 = 0.0, b2 = 0.0;
+    double sserr[FLUCT_NTAU_STEPS];
+
+    // prefix sums of the points, centred for accuracy
+    double mx = mean(logtt, ntt), my = mean(logFF, ntt);
+    double px[FLUCT_NTAU_STEPS+1], py[FLUCT_NTAU_STEPS+1];
+    double pxx[FLUCT_NTAU_STEPS+1], pxy[FLUCT_NTAU_STEPS+1], pyy[FLUCT_NTAU_STEPS+1];
+    px[0] = py[0] = pxx[0] = pxy[0] = pyy[0] = 0.0;
+    for (int j = 0; j < ntt; j++) {
+        double x = logtt[j] - mx, y = logFF[j] - my;
+        px[j+1] = px[j] + x;
+        py[j+1] = py[j] + y;
+        pxx[j+1] = pxx[j] + x*x;
+        pxy[j+1] = pxy[j] + x*y;
+        pyy[j+1] = pyy[j] + y*y;
+    }
 
+    for (int i = minPoints; i < ntt - minPoints + 1; i++) {
         sserr[i - minPoints] = 0.0;
-
-        linreg(i, logtt, logFF, &m1, &b1);
-        linreg(ntt-i+1, logtt+i-1, logFF+i-1, &m2, &b2);
-
-        for(int j = 0; j < i; j ++)
-        {
-            buffer[j] = logtt[j] * m1 + b1 - logFF[j];
-        }
-
-        sserr[i - minPoints] += norm_(buffer, i);
-
-        for(int j = 0; j < ntt-i+1; j++)
-        {
-            buffer[j] = logtt[j+i-1] * m2 + b2 - logFF[j+i-1];
+        // points [0, i) and [i-1, ntt)
+        int lo[2] = {0, i-1}, hi[2] = {i, ntt};
+        for (int s = 0; s < 2; s++) {
+            double n = hi[s] - lo[s];
+            double sx = px[hi[s]] - px[lo[s]], sy = py[hi[s]] - py[lo[s]];
+            double sxx = pxx[hi[s]] - pxx[lo[s]] - sx*sx/n;
+            double sxy = pxy[hi[s]] - pxy[lo[s]] - sx*sy/n;
+            double syy = pyy[hi[s]] - pyy[lo[s]] - sy*sy/n;
+            double rss = syy - sxy*sxy/sxx;
+            sserr[i - minPoints] += sqrt(rss < 0 ? 0.0 : rss);
         }
-
-        sserr[i - minPoints] += norm_(buffer, ntt-i+1);
-
     }
 
-    double firstMinInd = 0.0;
+    int firstMinInd = 0;
     double minimum = min_(sserr, nsserr);
-    for(int i = 0; i < nsserr; i++)
-    {
-        if(sserr[i] == minimum)
-        {
+    for (int i = 0; i < nsserr; i++) {
+        if (sserr[i] == minimum) {
             firstMinInd = i + minPoints - 1;
             break;
         }
     }
+    return firstMinInd;
+}
 
-    free(yCS); // new
+static int fluct_mode(const char how[])
+{
+    if (strcmp(how, "dfa") == 0) {
+        return FLUCT_DFA_1;
+    }
+    if (strcmp(how, "rsrangefit") == 0) {
+        return FLUCT_RSRANGE;
+    }
+    return -1;
+}
 
-    free(xReg);
-    free(F);
-    free(logtt);
-    free(logFF);
-    free(sserr);
-    free(buffer);
+double SC_FluctAnal_2_50_1_logi_prop_r1_ctx(feature_context * ctx, const int lag, const char how[])
+{
+    // NaN check
+    if(context_has_nan(ctx))
+    {
+        return NAN;
+    }
 
-    return (firstMinInd+1)/ntt;
+    fluct_analysis * fa = context_fluct(ctx);
+    int mode = fluct_mode(how);
+
+    // fewer than 12 points -> leave.
+    if(fa->nTau < 12 || mode < 0){
+        return 0;
+    }
+
+    double logFF[FLUCT_NTAU_STEPS];
+    context_fluct_logF(ctx, lag, mode, logFF);
+
+    int ntt = fa->nTau;
+    int firstMinInd = fluct_breakpoint(fa->logtt, logFF, ntt);
+
+    return (firstMinInd+1.0)/ntt;
+}
 
+double SC_FluctAnal_2_50_1_logi_prop_r1(const double y[], const int size, const int lag, const char how[])
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = SC_FluctAnal_2_50_1_logi_prop_r1_ctx(&ctx, lag, how);
+    context_free(&ctx);
+    return out;
 }
 
 double SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1(const double y[], const int size){
@@ -209,6 +491,14 @@ double SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1(const double y[], const int s
     return SC_FluctAnal_2_50_1_logi_prop_r1(y, size, 1, "rsrangefit");
 }
 
+double SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1_ctx(feature_context * ctx){
+    return SC_FluctAnal_2_50_1_logi_prop_r1_ctx(ctx, 2, "dfa");
+}
+
+double SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1_ctx(feature_context * ctx){
+    return SC_FluctAnal_2_50_1_logi_prop_r1_ctx(ctx, 1, "rsrangefit");
+}
+
 /*
 double SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1(double y[], int size)
 {
@@ -353,185 +643,73 @@ double SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1(double y[], int size)
 }
  */
 
-double dofit(const gsl_multifit_robust_type *T, const gsl_matrix *X, const gsl_vector *y,
-             gsl_vector *c, gsl_matrix *cov, int n)
+// standard error of the slope of a robust fit of y on the design X; work has
+// to be allocated for X's dimensions and can be reused across fits
+double dofit(const gsl_matrix *X, const gsl_vector *y, gsl_vector *c, gsl_matrix *cov,
+             gsl_multifit_robust_workspace * work)
 {
-    int s;
     gsl_set_error_handler_off();
 
-    gsl_multifit_robust_workspace * work = gsl_multifit_robust_alloc(T, X->size1, X->size2);
-
-    s = gsl_multifit_robust(X, y, c, cov, work);
+    gsl_multifit_robust(X, y, c, cov, work);
 
     //gsl_multifit_robust_stats stat = gsl_multifit_robust_statistics(work);
     return sqrt(gsl_matrix_get(cov, 1, 1)); // standard error of mean
 }
 
 // --- taustep = 50, k = 2 ---
-double SC_FluctAnal_2_dfa_50_2_logi_r2_se2(const double y[], const int size) {
+double SC_FluctAnal_2_dfa_50_2_logi_r2_se2_ctx(feature_context * ctx) {
 
     // NaN check
-    for (int i = 0; i < size; i++)
-        if (isnan(y[i]))
-            return NAN;
-
-        //int lag = 2;
-
-        // generate log spaced tau vector
-        double linLow = log(5);
-        double linHigh = log(size/2);
-
-        int nTauSteps = 50;
-        double tauStep = (linHigh - linLow) / (nTauSteps-1);
-
-        int tau[50];
-        for (int i = 0; i < nTauSteps; i++)
-            tau[i] = round(exp(linLow + i*tauStep));
-
-        // check for uniqueness, use ascending order
-        int nTau = nTauSteps;
-        for (int i = 0; i < nTauSteps-1; i++) {
-            while (tau[i] == tau[i+1] && i < nTau-1) {
-                for (int j = i+1; j < nTauSteps-1; j++)
-                    tau[j] = tau[j+1];
-                // lost one
-                nTau -= 1;
-            }
-        }
-
-        // fewer than 12 points -> leave.
-        if (nTau < 12) {
-            return 0;
-        }
-
-        int sizeCS = size;
-        double * yCS = malloc(sizeCS * sizeof(double));
-
-        // transform input vector to cumsum
-        yCS[0] = y[0];
-        for (int i = 0; i < sizeCS-1; i++)
-            yCS[i+1] = yCS[i] + y[(i+1)];
+    if (context_has_nan(ctx))
+        return NAN;
 
-        //for each value of tau, cut signal into snippets of length tau, detrend and
+    fluct_analysis * fa = context_fluct(ctx);
 
-        // first generate a support for regression (detrending)
-        double * xReg = malloc(tau[nTau-1] * sizeof * xReg);
-        for (int i = 0; i < tau[nTau-1]; i++)
-            xReg[i] = i+1;
-
-        // iterate over taus, cut signal, detrend and save amplitude of remaining signal
-        double * F = malloc(nTau * sizeof * F);
-        for (int i = 0; i < nTau; i++) {
-            int nBuffer = sizeCS/tau[i];
-            double * buffer = malloc(tau[i] * sizeof * buffer);
-            //double m = 0.0, b = 0.0;
-            double *coeff = (double*) malloc(3 * sizeof(double));
-            //printf("tau[%i]=%i\n", i, tau[i]);
-
-            F[i] = 0;
-            for (int j = 0; j < nBuffer; j++) {
-                /* Polynomial linear regression of order 2 */
-
-                //linreg(tau[i], xReg, yCS+j*tau[i], &m, &b); // quad_linreg() -- 3 coefficients
-                polynomialfit(tau[i], 2 + 1, xReg, yCS+j*tau[i], coeff);
-                //printf("%lf, %lf, %lf\n", coeff[0], coeff[1], coeff[2]);
-
-                for (int k = 0; k < tau[i]; k++) {
-                    buffer[k] = yCS[j*tau[i]+k] - ((coeff[2] * pow(k+1, 2)) + (coeff[1] * (k+1)) + coeff[0]);
-                    //printf("buffer[%i]=%1.3f\n", k, buffer[k]);
-                }
-                for(int k = 0; k < tau[i]; k++)
-                    F[i] += buffer[k]*buffer[k];
-            }
-
-            //if (strcmp(how, "dfa") == 0)
-            F[i] = sqrt(F[i] / (nBuffer * tau[i]));
-            free(buffer);
-        }
-
-        double * logtt = malloc(nTau * sizeof * logtt);
-        double * logFF = malloc(nTau * sizeof * logFF);
-        int ntt = nTau;
-
-        for (int i = 0; i < nTau; i++) {
-            logtt[i] = log(tau[i]);
-            logFF[i] = log(F[i]);
-        }
-
-        int minPoints = 6;
-        int nsserr = (ntt - 2*minPoints + 1);
-        double * sserr = malloc(nsserr * sizeof * sserr);
-        double * buffer = malloc((ntt - minPoints + 1) * sizeof * buffer);
-        for (int i = minPoints; i < ntt - minPoints + 1; i++) {
-            // this could be done with less variables of course
-            double m1 = 0.0, b1 = 0.0;
-            double m2 = 0.0, b2 = 0.0;
-
-            sserr[i - minPoints] = 0.0; // i
-
-            linreg(i, logtt, logFF, &m1, &b1);
-            linreg(ntt-i+1, logtt+i-1, logFF+i-1, &m2, &b2);
-
-            for (int j = 0; j < i; j ++)
-                buffer[j] = logtt[j] * m1 + b1 - logFF[j];
-
-            sserr[i - minPoints] += norm_(buffer, i); // i
-
-            for (int j = 0; j < ntt-i+1; j++)
-                buffer[j] = logtt[j+i-1] * m2 + b2 - logFF[j+i-1];
-
-            sserr[i - minPoints] += norm_(buffer, ntt-i+1); // i
-        }
+    // fewer than 12 points -> leave.
+    if (fa->nTau < 12) {
+        return 0;
+    }
 
-        double firstMinInd = 0.0;
-        double minimum = min_(sserr, nsserr);
+    // fluctuation function of the cumsum, detrended with a quadratic
+    double logFF[FLUCT_NTAU_STEPS];
+    context_fluct_logF(ctx, 1, FLUCT_DFA_2, logFF);
+    const double * logtt = fa->logtt;
+
+    int ntt = fa->nTau;
+    int firstMinInd = fluct_breakpoint(logtt, logFF, ntt);
+
+    int r2_len = ntt - firstMinInd;
+
+    /* Robust fitting starts here (uses bi-squared objective function) */
+
+    const size_t p = 2; // linear fit -- two coefficients
+    gsl_matrix *X, *cov;
+    gsl_vector *c, *r2_logFF;
+    c = gsl_vector_alloc(p);
+    X = gsl_matrix_alloc(r2_len, p);
+    cov = gsl_matrix_alloc(p, p);
+    r2_logFF = gsl_vector_alloc(r2_len);
+    gsl_multifit_robust_workspace * work = gsl_multifit_robust_alloc(gsl_multifit_robust_bisquare, r2_len, p);
+    // construct design matrix X for linear fit on the second regime
+    for (int i = 0; i < r2_len; ++i) {
+        gsl_matrix_set(X, i, 0, 1);
+        gsl_matrix_set(X, i, 1, logtt[firstMinInd + i]);
+        gsl_vector_set(r2_logFF, i, logFF[firstMinInd + i]);
+    }
+    double out = dofit(X, r2_logFF, c, cov, work);
+
+    gsl_multifit_robust_free(work);
+    gsl_matrix_free(X);
+    gsl_vector_free(c);
+    gsl_matrix_free(cov);
+    gsl_vector_free(r2_logFF);
+    return out;
+}
 
-        for (int i = 0; i < nsserr; i++) {
-            if (sserr[i] == minimum) {
-                firstMinInd = i + minPoints - 1;
-                break;
-            }
-        }
-        int r2_len = ntt - firstMinInd;
-        int *r2 = (int*) malloc((r2_len)*sizeof(int));
-
-        gsl_vector *r2_logtt, *r2_logFF;
-        r2_logtt = gsl_vector_alloc(r2_len);
-        r2_logFF = gsl_vector_alloc(r2_len);
-        for (int i = 0; i < r2_len; i++) {
-            r2[i] = firstMinInd + i;
-            gsl_vector_set(r2_logtt, i, logtt[r2[i]]);
-            gsl_vector_set(r2_logFF, i, logFF[r2[i]]);
-        }
-        /* Robust fitting starts here (uses bi-squared objective function) */
-
-        const size_t p = 2; // linear fit -- two coefficients
-        gsl_matrix *X, *cov;
-        gsl_vector *c;
-        c = gsl_vector_alloc(p);
-        X = gsl_matrix_alloc(r2_len, p);
-        cov = gsl_matrix_alloc(p, p);
-        // construct design matrix X for linear fit
-        for (int i = 0; i < r2_len; ++i) {
-            double xi = gsl_vector_get(r2_logtt, i);
-
-            gsl_matrix_set(X, i, 0, 1);
-            gsl_matrix_set(X, i, 1, xi);
-        }
-        double out = dofit(gsl_multifit_robust_bisquare, X, r2_logFF, c, cov, r2_len);
-
-        gsl_matrix_free(X);
-        gsl_vector_free(c);
-        gsl_matrix_free(cov);
-        gsl_vector_free(r2_logtt);
-        gsl_vector_free(r2_logFF);
-        free(r2);
-        free(yCS);
-        free(xReg);
-        free(F);
-        free(logtt);
-        free(logFF);
-        free(sserr);
-        free(buffer);
-        return out;
+double SC_FluctAnal_2_dfa_50_2_logi_r2_se2(const double y[], const int size) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = SC_FluctAnal_2_dfa_50_2_logi_r2_se2_ctx(&ctx);
+    context_free(&ctx);
+    return out;
 }
@@ -4,9 +4,20 @@
 #include <string.h>
 #include "stats.h"
 #include "CO_AutoCorr.h"
+#include "feature_context.h"
+
+// tau grid, cumulative sums and fluctuation functions shared by the
+// SC_FluctAnal features of one series; owned by the feature context
+typedef struct fluct_analysis fluct_analysis;
+extern void fluct_analysis_free(fluct_analysis * fa);
 
 extern double SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1(const double y[], const int size);
 extern double SC_FluctAnal_2_50_1_logi_prop_r1(const double y[], const int size, const int lag, const char how[]);
 extern double SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1(const double y[], const int size);
 extern double SC_FluctAnal_2_dfa_50_2_logi_r2_se2(const double y[], const int size);
+
+extern double SC_FluctAnal_2_50_1_logi_prop_r1_ctx(feature_context * ctx, const int lag, const char how[]);
+extern double SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1_ctx(feature_context * ctx);
+extern double SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1_ctx(feature_context * ctx);
+extern double SC_FluctAnal_2_dfa_50_2_logi_r2_se2_ctx(feature_context * ctx);
 #endif
@@ -7,162 +7,136 @@
 
 #include "SP_Summaries.h"
 #include "CO_AutoCorr.h"
+#include "feature_context.h"
 
-int welch(const double y[], const int size, const int NFFT, const double Fs, const double window[], const int windowWidth, double ** Pxx, double ** f){
-    
+// Welch power of y with a rectangular window covering the whole series,
+// which gives a single segment. The window is implicit, so there is no window array and
+// no windowed copy of the series. Returns the Nout = NFFT/2+1 bins.
+static int welch_rect(const double y[], const int size, const int NFFT, const double Fs, double Pxx[])
+{
     double dt = 1.0/Fs;
-    double df = 1.0/(nextpow2(windowWidth))/dt;
     double m = mean(y, size);
     
-    // number of windows, should be 1
-    int k = floor((double)size/((double)windowWidth/2.0))-1;
-    
-    // normalising scale factor
-    double KMU = k * pow(norm_(window, windowWidth),2);
+    // normalising scale factor; the window has squared norm size. Squaring
+    // sqrt(size), as the old norm_(window) path did, keeps the spectrum
+    // bit-identical: the result can be an ulp away from size itself
+    double KMU = pow(sqrt((double)size), 2);
     
-    double * P = malloc(NFFT * sizeof(double));
-    for(int i = 0; i < NFFT; i++){
-        P[i] = 0;
-    }
+    int Nout = (NFFT/2+1);
     
-    // fft variables
-    cplx * F = malloc(NFFT * sizeof *F);
-    cplx * tw = malloc(NFFT * sizeof *tw);
-    twiddles(tw, NFFT);
+    fft_plan * plan = fft_plan_acquire(NFFT);
+    double * xF = malloc(NFFT * sizeof(double));
+    double * FRe = malloc(Nout * sizeof(double));
+    double * FIm = malloc(Nout * sizeof(double));
     
-    double * xw = malloc(windowWidth * sizeof(double));
-    for(int i = 0; i<k; i++){
-        
-        // apply window
-        for(int j = 0; j<windowWidth; j++){
-            xw[j] = window[j]*y[j + (int)(i*(double)windowWidth/2.0)];
-        }
-        
-        // initialise F (
-        for (int i = 0; i < windowWidth; i++) {
-            
-	    #if defined(__GNUC__) || defined(__GNUG__)
-		cplx tmp = xw[i] - m + 0.0 * I;
-	    #elif defined(_MSC_VER)
-		cplx tmp = { xw[i] - m, 0.0 };
-	    #endif
-            
-            
-            F[i] = tmp; // CMPLX(xw[i] - m, 0.0);
-        }
-        for (int i = windowWidth; i < NFFT; i++) {
-            // F[i] = CMPLX(0.0, 0.0);
-            //cplx tmp = { 0.0, 0.0 };
-            #if defined(__GNUC__) || defined(__GNUG__)
-		cplx tmp = 0.0 + 0.0 * I;
-	    #elif defined(_MSC_VER)
-		cplx tmp = { 0.0 , 0.0 };
-	    #endif
-            F[i] = tmp;
-        }
-        
-        fft(F, NFFT, tw);
-        /*
-        for(int i = 0; i < NFFT; i++){
-            printf("F1[%i] real: %1.3f, imag: %1.3f\n", i, creal(F[i]), cimag(F[i]));
-        }
-         */
-        
-        for(int l = 0; l < NFFT; l++){
-            P[l] += pow(cabs(F[l]),2);
-        }
-        /*
-        for(int i = 0; i < NFFT; i++){
-            printf("P[%i]: %1.3f\n", i, P[i]);
-        }
-         */
-        
+    for (int i = 0; i < size; i++) {
+        xF[i] = y[i] - m;
     }
-    
-    int Nout = (NFFT/2+1);
-    *Pxx = malloc(Nout * sizeof(double));
-    for(int i = 0; i < Nout; i++){
-        (*Pxx)[i] = P[i]/KMU*dt;
-        if(i>0 & i < Nout-1){
-            (*Pxx)[i] *= 2;
-        }
+    for (int i = size; i < NFFT; i++) {
+        xF[i] = 0.0;
     }
-    /*
-    for(int i = 0; i < Nout; i++){
-        printf("Pxx[%i]: %1.3f\n", i, Pxx[i]);
-    }
-     */
     
-    *f = malloc(Nout * sizeof(double));
-    for(int i = 0; i < Nout; i++){
-        (*f)[i] = (double)i*df;
-    }
-    /*
+    rfft(plan, xF, FRe, FIm);
+    
     for(int i = 0; i < Nout; i++){
-        printf("f[%i]: %1.3f\n", i, (*f)[i]);
+        Pxx[i] = (FRe[i]*FRe[i] + FIm[i]*FIm[i])/KMU*dt;
+        if(i > 0 && i < Nout-1){
+            Pxx[i] *= 2;
+        }
     }
-     */
     
-    free(P);
-    free(F);
-    free(tw);
-    free(xw);
+    free(xF);
+    free(FRe);
+    free(FIm);
+    fft_plan_release(plan);
     
     return Nout;
 }
 
-double SP_Summaries_welch_rect(const double y[], const int size, const char what[])
+#define WELCH_PI 3.14159265359
+
+// Welch spectrum on angular frequency, shared by all spectral summaries of
+// a series
+struct welch_spectrum {
+    int n;              // number of bins
+    int hasInf;         // any infinite bin? summaries are 0 then
+    double df;          // bin width in frequency
+    double dw;          // bin width in angular frequency
+    double * Sw;        // power per bin
+    double * csS;       // cumulative power
+};
+
+void welch_spectrum_free(welch_spectrum * ws)
 {
-    
-    // NaN check
-    for(int i = 0; i < size; i++)
-    {
-        if(isnan(y[i]))
-        {
-            return NAN;
-        }
+    if (ws == NULL) {
+        return;
     }
-    
-    // rectangular window for Welch-spectrum
-    double * window = malloc(size * sizeof(double));
-    for(int i = 0; i < size; i++){
-        window[i] = 1;
+    free(ws->Sw);
+    free(ws->csS);
+    free(ws);
+}
+
+// angular frequency of bin i
+static double welch_w(const welch_spectrum * ws, const int i)
+{
+    return 2*WELCH_PI*((double)i*ws->df);
+}
+
+static welch_spectrum * context_welch(feature_context * ctx)
+{
+    if (ctx->welch != NULL) {
+        return ctx->welch;
     }
     
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
+    
     double Fs = 1.0; // sampling frequency
     int N = nextpow2(size);
+    double df = 1.0/(N)/(1.0/Fs);
     
-    double * S;
-    double * f;
+    welch_spectrum * ws = malloc(sizeof * ws);
+    ws->n = N/2+1;
+    ws->Sw = malloc(ws->n * sizeof(double));
+    ws->csS = malloc(ws->n * sizeof(double));
     
     // compute Welch-power
-    int nWelch = welch(y, size, N, Fs, window, size, &S, &f);
-    free(window);
-    
-    // angualr frequency and spectrum on that
-    double * w = malloc(nWelch * sizeof(double));
-    double * Sw = malloc(nWelch * sizeof(double));
-    
-    double PI = 3.14159265359;
-    for(int i = 0; i < nWelch; i++){
-        w[i] = 2*PI*f[i];
-        Sw[i] = S[i]/(2*PI);
-        //printf("w[%i]=%1.3f, Sw[%i]=%1.3f\n", i, w[i], i, Sw[i]);
-        if(isinf(Sw[i]) | isinf(-Sw[i])){
-            return 0;
+    welch_rect(y, size, N, Fs, ws->Sw);
+    
+    // spectrum on angular frequency
+    ws->hasInf = 0;
+    for(int i = 0; i < ws->n; i++){
+        ws->Sw[i] = ws->Sw[i]/(2*WELCH_PI);
+        if(isinf(ws->Sw[i]) | isinf(-ws->Sw[i])){
+            ws->hasInf = 1;
         }
     }
+    ws->df = df;
+    ws->dw = welch_w(ws, 1) - welch_w(ws, 0);
     
-    double dw = w[1] - w[0];
+    cumsum(ws->Sw, ws->n, ws->csS);
     
-    double * csS = malloc(nWelch * sizeof(double));
-    cumsum(Sw, nWelch, csS);
-    /*
-    for(int i=0; i<nWelch; i++)
+    ctx->welch = ws;
+    return ws;
+}
+
+double SP_Summaries_welch_rect_ctx(feature_context * ctx, const char what[])
+{
+    
+    // NaN check
+    if(context_has_nan(ctx))
     {
-        printf("csS[%i]=%1.3f\n", i, csS[i]);
+        return NAN;
     }
-     */
+    
+    const welch_spectrum * ws = context_welch(ctx);
+    if(ws->hasInf){
+        return 0;
+    }
+    
+    const int nWelch = ws->n;
+    const double * Sw = ws->Sw;
+    const double * csS = ws->csS;
     
     double output = 0;
     
@@ -172,7 +146,7 @@ double SP_Summaries_welch_rect(const double y[], const int size, const char what
         double centroid = 0;
         for(int i = 0; i < nWelch; i ++){
             if(csS[i] > csSThres){
-                centroid = w[i];
+                centroid = welch_w(ws, i);
                 break;
             }
         }
@@ -185,22 +159,37 @@ double SP_Summaries_welch_rect(const double y[], const int size, const char what
         for(int i=0; i<nWelch/5; i++){
             area_5_1 += Sw[i];
         }
-        area_5_1 *= dw;
+        area_5_1 *= ws->dw;
         
         output = area_5_1;
     }
-    
-    free(w);
-    free(Sw);
-    free(csS);
-    free(f);
-    free(S);
+    else if(strcmp(what, "entropy") == 0){
+        // entropy of the spectrum normalised to unit total power
+        double total = csS[nWelch-1];
+        double entropy = 0;
+        for(int i = 0; i < nWelch; i++){
+            if(Sw[i] > 0){
+                double p = Sw[i]/total;
+                entropy -= p*log(p);
+            }
+        }
+        
+        output = entropy;
+    }
     
     return output;
     
     
 }
 
+double SP_Summaries_welch_rect(const double y[], const int size, const char what[])
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = SP_Summaries_welch_rect_ctx(&ctx, what);
+    context_free(&ctx);
+    return out;
+}
 
 double SP_Summaries_welch_rect_area_5_1(const double y[], const int size)
 {
@@ -211,3 +200,55 @@ double SP_Summaries_welch_rect_centroid(const double y[], const int size)
     return SP_Summaries_welch_rect(y, size, "centroid");
     
 }
+
+double SP_Summaries_welch_rect_area_5_1_ctx(feature_context * ctx)
+{
+    return SP_Summaries_welch_rect_ctx(ctx, "area_5_1");
+}
+double SP_Summaries_welch_rect_centroid_ctx(feature_context * ctx)
+{
+    return SP_Summaries_welch_rect_ctx(ctx, "centroid");
+}
+
+double SP_Summaries_welch_rect_entropy(const double y[], const int size)
+{
+    return SP_Summaries_welch_rect(y, size, "entropy");
+}
+double SP_Summaries_welch_rect_entropy_ctx(feature_context * ctx)
+{
+    return SP_Summaries_welch_rect_ctx(ctx, "entropy");
+}
+
+void SP_Summaries_welch_rect_bandpowers_ctx(feature_context * ctx, const int nBands, double out[])
+{
+    // NaN check
+    if(context_has_nan(ctx))
+    {
+        for(int k = 0; k < nBands; k++){
+            out[k] = NAN;
+        }
+        return;
+    }
+    
+    const welch_spectrum * ws = context_welch(ctx);
+    
+    // band k holds the bins [k*n/nBands, (k+1)*n/nBands); band 0 of 5 is area_5_1
+    for(int k = 0; k < nBands; k++){
+        double power = 0;
+        if(!ws->hasInf){
+            for(int i = k*ws->n/nBands; i < (k+1)*ws->n/nBands; i++){
+                power += ws->Sw[i];
+            }
+            power *= ws->dw;
+        }
+        out[k] = power;
+    }
+}
+
+void SP_Summaries_welch_rect_bandpowers(const double y[], const int size, const int nBands, double out[])
+{
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    SP_Summaries_welch_rect_bandpowers_ctx(&ctx, nBands, out);
+    context_free(&ctx);
+}
@@ -9,9 +9,24 @@
 #define SP_Summaries_h
 
 #include <stdio.h>
+#include "feature_context.h"
 
 extern double SP_Summaries_welch_rect(const double y[], const int size, const char what[]);
 extern double SP_Summaries_welch_rect_area_5_1(const double y[], const int size);
 extern double SP_Summaries_welch_rect_centroid(const double y[], const int size);
+extern double SP_Summaries_welch_rect_ctx(feature_context * ctx, const char what[]);
+extern double SP_Summaries_welch_rect_area_5_1_ctx(feature_context * ctx);
+extern double SP_Summaries_welch_rect_centroid_ctx(feature_context * ctx);
+// entropy of the Welch spectrum normalised to unit power
+extern double SP_Summaries_welch_rect_entropy(const double y[], const int size);
+extern double SP_Summaries_welch_rect_entropy_ctx(feature_context * ctx);
+// spectral power in nBands equal bands of bins, lowest first
+extern void SP_Summaries_welch_rect_bandpowers(const double y[], const int size, const int nBands, double out[]);
+extern void SP_Summaries_welch_rect_bandpowers_ctx(feature_context * ctx, const int nBands, double out[]);
+
+// Welch spectrum of a series, kept in its feature context so all spectral
+// summaries share one FFT
+typedef struct welch_spectrum welch_spectrum;
+extern void welch_spectrum_free(welch_spectrum * ws);
 
 #endif /* SP_Summaries_h */
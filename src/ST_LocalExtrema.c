@@ -1,6 +1,9 @@
 #include "ST_LocalExtrema.h"
 
-double ST_LocalExtrema_n100_diffmaxabsmin(const double y[], const int size) {
+double ST_LocalExtrema_n100_diffmaxabsmin_ctx(feature_context * ctx) {
+    
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
     
     int num_windows = 100;
     int wl = floor(size/num_windows);
@@ -47,3 +50,11 @@ double ST_LocalExtrema_n100_diffmaxabsmin(const double y[], const int size) {
     
     return diffmaxabsmin;
 }
+
+double ST_LocalExtrema_n100_diffmaxabsmin(const double y[], const int size) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = ST_LocalExtrema_n100_diffmaxabsmin_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
@@ -5,7 +5,9 @@
 #include <math.h>
 #include <stdlib.h>
 #include "stats.h"
+#include "feature_context.h"
 
 extern double ST_LocalExtrema_n100_diffmaxabsmin(const double y[], const int size);
+extern double ST_LocalExtrema_n100_diffmaxabsmin_ctx(feature_context * ctx);
 
 #endif
@@ -1,12 +1,14 @@
 #include "SY_DriftingMean.h"
 
-double SY_DriftingMean50_min(const double y[], const int size) { // let size = 200
+double SY_DriftingMean50_min_ctx(feature_context * ctx) { // let size = 200
 
     // check NAN
     int i, j;
-    for (i = 0; i < size; i++)
-        if (isnan(y[i]))
-            return NAN;
+    if (context_has_nan(ctx))
+        return NAN;
+
+    const double * y = context_y(ctx);
+    const int size = ctx->size;
         
     int l = 50; // Divide the time series into 50-sample segments
     int numFits = floor(size/l); // = 4
@@ -35,3 +37,11 @@ double SY_DriftingMean50_min(const double y[], const int size) { // let size = 2
     
     return out;   
 }
+
+double SY_DriftingMean50_min(const double y[], const int size) {
+    feature_context ctx;
+    context_init(&ctx, y, size, 0);
+    double out = SY_DriftingMean50_min_ctx(&ctx);
+    context_free(&ctx);
+    return out;
+}
@@ -3,7 +3,9 @@
 #include <stdio.h>
 #include <math.h>
 #include "stats.h"
+#include "feature_context.h"
 
 extern double SY_DriftingMean50_min(const double y[], const int size);
+extern double SY_DriftingMean50_min_ctx(feature_context * ctx);
 
 #endif
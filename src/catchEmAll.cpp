@@ -8,6 +8,7 @@ extern "C" {
 #include "CO_AutoCorr.h"
 #include "DN_HistogramMode_10.h"
 #include "DN_HistogramMode_5.h"
+#include "DN_HistogramMode.h"
 #include "DN_OutlierInclude.h"
 #include "FC_LocalSimple.h"
 #include "IN_AutoMutualInfoStats.h"
@@ -34,38 +35,22 @@ extern "C" {
 #include "histcounts.h"
 #include "splinefit.h"
 #include "stats.h"
+#include "feature_context.h"
+#include "feature_sets.h"
 }
 
 using namespace Rcpp;
 
-// universal wrapper for a function that takes a double array and its length
+// universal wrapper for a feature that reads from a per-series context
 // and outputs a scalar double
-NumericVector R_wrapper_double(NumericVector x, double (*f) (const double*, const int), int normalize) {
+NumericVector R_wrapper_double(NumericVector x, double (*f) (feature_context*), int normalize) {
 
-  int n = x.size();
-  double * arrayC = new double[n];
-  double out;
-
-  int i;
-  for (i=0; i<n; i++){
-    arrayC[i] = x[i];
-  }
-
-  if (normalize){
+  feature_context ctx;
+  context_init(&ctx, x.begin(), x.size(), normalize);
 
-        double * y_zscored = new double[n];
+  double out = f(&ctx);
 
-        zscore_norm2(arrayC, n, y_zscored);
-
-        out = f(y_zscored, n);
-
-        // free(y_zscored);
-    }
-    else {
-        out = f(arrayC, n);
-    }
-
-    // free(arrayC);
+  context_free(&ctx);
 
   NumericVector outVec = NumericVector::create(out);
 
@@ -73,34 +58,16 @@ NumericVector R_wrapper_double(NumericVector x, double (*f) (const double*, cons
 
 };
 
-// universal wrapper for a function that takes a double array and its length
-// and outputs a scalar double
-NumericVector R_wrapper_int(NumericVector x, int (*f) (const double*, const int), int normalize) {
-
-  int n = x.size();
-  double * arrayC = new double[n];
-  int out;
-
-  int i;
-  for (i=0; i<n; i++){
-    arrayC[i] = x[i];
-  }
-
-  if (normalize){
+// universal wrapper for a feature that reads from a per-series context
+// and outputs a scalar int
+NumericVector R_wrapper_int(NumericVector x, int (*f) (feature_context*), int normalize) {
 
-        double * y_zscored = new double[n];
+  feature_context ctx;
+  context_init(&ctx, x.begin(), x.size(), normalize);
 
-        zscore_norm2(arrayC, n, y_zscored);
+  int out = f(&ctx);
 
-        out = f(y_zscored, n);
-
-        // free(y_zscored);
-    }
-    else {
-        out = f(arrayC, n);
-    }
-
-    // free(arrayC);
+  context_free(&ctx);
 
   NumericVector outVec = NumericVector::create(out);
 
@@ -140,7 +107,7 @@ NumericVector CO_Embed2_Basic_tau_incircle_1(NumericVector x) {
 // [[Rcpp::export]]
 NumericVector DN_HistogramMode_5(NumericVector x)
 {
-  return R_wrapper_double(x, &DN_HistogramMode_5, 1);
+  return R_wrapper_double(x, &DN_HistogramMode_5_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -156,7 +123,7 @@ NumericVector DN_HistogramMode_5(NumericVector x)
 // [[Rcpp::export]]
 NumericVector DN_HistogramMode_10(NumericVector x)
 {
-  return R_wrapper_double(x, &DN_HistogramMode_10, 1);
+  return R_wrapper_double(x, &DN_HistogramMode_10_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -172,7 +139,7 @@ NumericVector DN_HistogramMode_10(NumericVector x)
 // [[Rcpp::export]]
 NumericVector CO_f1ecac(NumericVector x)
 {
-  return R_wrapper_int(x, &CO_f1ecac, 1);
+  return R_wrapper_int(x, &CO_f1ecac_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -188,7 +155,7 @@ NumericVector CO_f1ecac(NumericVector x)
 // [[Rcpp::export]]
 NumericVector CO_FirstMin_ac(NumericVector x)
 {
-  return R_wrapper_int(x, &CO_FirstMin_ac, 1);
+  return R_wrapper_int(x, &CO_FirstMin_ac_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -204,7 +171,7 @@ NumericVector CO_FirstMin_ac(NumericVector x)
 // [[Rcpp::export]]
 NumericVector CO_HistogramAMI_even_2_5(NumericVector x)
 {
-  return R_wrapper_double(x, &CO_HistogramAMI_even_2_5, 1);
+  return R_wrapper_double(x, &CO_HistogramAMI_even_2_5_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -220,7 +187,7 @@ NumericVector CO_HistogramAMI_even_2_5(NumericVector x)
 // [[Rcpp::export]]
 NumericVector CO_trev_1_num(NumericVector x)
 {
-  return R_wrapper_double(x, &CO_trev_1_num, 1);
+  return R_wrapper_double(x, &CO_trev_1_num_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -236,7 +203,7 @@ NumericVector CO_trev_1_num(NumericVector x)
 // [[Rcpp::export]]
 NumericVector MD_hrv_classic_pnn40(NumericVector x)
 {
-  return R_wrapper_double(x, &MD_hrv_classic_pnn40, 1);
+  return R_wrapper_double(x, &MD_hrv_classic_pnn40_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -252,7 +219,7 @@ NumericVector MD_hrv_classic_pnn40(NumericVector x)
 // [[Rcpp::export]]
 NumericVector SB_BinaryStats_mean_longstretch1(NumericVector x)
 {
-  return R_wrapper_double(x, &SB_BinaryStats_mean_longstretch1, 1);
+  return R_wrapper_double(x, &SB_BinaryStats_mean_longstretch1_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -268,7 +235,7 @@ NumericVector SB_BinaryStats_mean_longstretch1(NumericVector x)
 // [[Rcpp::export]]
 NumericVector SB_TransitionMatrix_3ac_sumdiagcov(NumericVector x)
 {
-  return R_wrapper_double(x, &SB_TransitionMatrix_3ac_sumdiagcov, 1);
+  return R_wrapper_double(x, &SB_TransitionMatrix_3ac_sumdiagcov_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -284,7 +251,7 @@ NumericVector SB_TransitionMatrix_3ac_sumdiagcov(NumericVector x)
 // [[Rcpp::export]]
 NumericVector PD_PeriodicityWang_th0_01(NumericVector x)
 {
-  return R_wrapper_int(x, &PD_PeriodicityWang_th0_01, 1);
+  return R_wrapper_int(x, &PD_PeriodicityWang_th0_01_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -300,7 +267,7 @@ NumericVector PD_PeriodicityWang_th0_01(NumericVector x)
 // [[Rcpp::export]]
 NumericVector CO_Embed2_Dist_tau_d_expfit_meandiff(NumericVector x)
 {
-  return R_wrapper_double(x, &CO_Embed2_Dist_tau_d_expfit_meandiff, 1);
+  return R_wrapper_double(x, &CO_Embed2_Dist_tau_d_expfit_meandiff_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -316,7 +283,7 @@ NumericVector CO_Embed2_Dist_tau_d_expfit_meandiff(NumericVector x)
 // [[Rcpp::export]]
 NumericVector IN_AutoMutualInfoStats_40_gaussian_fmmi(NumericVector x)
 {
-  return R_wrapper_double(x, &IN_AutoMutualInfoStats_40_gaussian_fmmi, 1);
+  return R_wrapper_double(x, &IN_AutoMutualInfoStats_40_gaussian_fmmi_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -332,7 +299,7 @@ NumericVector IN_AutoMutualInfoStats_40_gaussian_fmmi(NumericVector x)
 // [[Rcpp::export]]
 NumericVector FC_LocalSimple_mean1_tauresrat(NumericVector x)
 {
-  return R_wrapper_double(x, &FC_LocalSimple_mean1_tauresrat, 1);
+  return R_wrapper_double(x, &FC_LocalSimple_mean1_tauresrat_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -348,7 +315,7 @@ NumericVector FC_LocalSimple_mean1_tauresrat(NumericVector x)
 // [[Rcpp::export]]
 NumericVector DN_OutlierInclude_p_001_mdrmd(NumericVector x)
 {
-  return R_wrapper_double(x, &DN_OutlierInclude_p_001_mdrmd, 1);
+  return R_wrapper_double(x, &DN_OutlierInclude_p_001_mdrmd_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -364,7 +331,7 @@ NumericVector DN_OutlierInclude_p_001_mdrmd(NumericVector x)
 // [[Rcpp::export]]
 NumericVector DN_OutlierInclude_n_001_mdrmd(NumericVector x)
 {
-  return R_wrapper_double(x, &DN_OutlierInclude_n_001_mdrmd, 1);
+  return R_wrapper_double(x, &DN_OutlierInclude_n_001_mdrmd_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -380,7 +347,7 @@ NumericVector DN_OutlierInclude_n_001_mdrmd(NumericVector x)
 // [[Rcpp::export]]
 NumericVector SP_Summaries_welch_rect_area_5_1(NumericVector x)
 {
-  return R_wrapper_double(x, &SP_Summaries_welch_rect_area_5_1, 1);
+  return R_wrapper_double(x, &SP_Summaries_welch_rect_area_5_1_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -396,7 +363,7 @@ NumericVector SP_Summaries_welch_rect_area_5_1(NumericVector x)
 // [[Rcpp::export]]
 NumericVector SB_BinaryStats_diff_longstretch0(NumericVector x)
 {
-  return R_wrapper_double(x, &SB_BinaryStats_diff_longstretch0, 1);
+  return R_wrapper_double(x, &SB_BinaryStats_diff_longstretch0_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -412,7 +379,7 @@ NumericVector SB_BinaryStats_diff_longstretch0(NumericVector x)
 // [[Rcpp::export]]
 NumericVector SB_MotifThree_quantile_hh(NumericVector x)
 {
-  return R_wrapper_double(x, &SB_MotifThree_quantile_hh, 1);
+  return R_wrapper_double(x, &SB_MotifThree_quantile_hh_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -428,7 +395,7 @@ NumericVector SB_MotifThree_quantile_hh(NumericVector x)
 // [[Rcpp::export]]
 NumericVector SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1(NumericVector x)
 {
-  return R_wrapper_double(x, &SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1, 1);
+  return R_wrapper_double(x, &SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -444,7 +411,7 @@ NumericVector SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1(NumericVector x)
 // [[Rcpp::export]]
 NumericVector SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1(NumericVector x)
 {
-  return R_wrapper_double(x, &SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1, 1);
+  return R_wrapper_double(x, &SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -460,7 +427,7 @@ NumericVector SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1(NumericVector x)
 // [[Rcpp::export]]
 NumericVector SP_Summaries_welch_rect_centroid(NumericVector x)
 {
-  return R_wrapper_double(x, &SP_Summaries_welch_rect_centroid, 1);
+  return R_wrapper_double(x, &SP_Summaries_welch_rect_centroid_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -476,7 +443,7 @@ NumericVector SP_Summaries_welch_rect_centroid(NumericVector x)
 // [[Rcpp::export]]
 NumericVector FC_LocalSimple_mean3_stderr(NumericVector x)
 {
-  return R_wrapper_double(x, &FC_LocalSimple_mean3_stderr, 1);
+  return R_wrapper_double(x, &FC_LocalSimple_mean3_stderr_ctx, 1);
 }
 
 
@@ -498,7 +465,7 @@ NumericVector FC_LocalSimple_mean3_stderr(NumericVector x)
 // [[Rcpp::export]]
 NumericVector SY_DriftingMean50_min(NumericVector x)
 {
-  return R_wrapper_double(x, &SY_DriftingMean50_min, 1);
+  return R_wrapper_double(x, &SY_DriftingMean50_min_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -514,7 +481,7 @@ NumericVector SY_DriftingMean50_min(NumericVector x)
 // [[Rcpp::export]]
 NumericVector CO_AddNoise_1_even_10_ami_at_10(NumericVector x)
 {
-  return R_wrapper_double(x, &CO_AddNoise_1_even_10_ami_at_10, 1);
+  return R_wrapper_double(x, &CO_AddNoise_1_even_10_ami_at_10_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -530,7 +497,7 @@ NumericVector CO_AddNoise_1_even_10_ami_at_10(NumericVector x)
 // [[Rcpp::export]]
 NumericVector AC_nl_036(NumericVector x)
 {
-  return R_wrapper_double(x, &AC_nl_036, 1);
+  return R_wrapper_double(x, &AC_nl_036_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -546,7 +513,7 @@ NumericVector AC_nl_036(NumericVector x)
 // [[Rcpp::export]]
 NumericVector AC_nl_035(NumericVector x)
 {
-  return R_wrapper_double(x, &AC_nl_035, 1);
+  return R_wrapper_double(x, &AC_nl_035_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -562,7 +529,7 @@ NumericVector AC_nl_035(NumericVector x)
 // [[Rcpp::export]]
 NumericVector AC_nl_112(NumericVector x)
 {
-  return R_wrapper_double(x, &AC_nl_112, 1);
+  return R_wrapper_double(x, &AC_nl_112_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -578,7 +545,7 @@ NumericVector AC_nl_112(NumericVector x)
 // [[Rcpp::export]]
 NumericVector IN_AutoMutualInfoStats_diff_20_gaussian_ami8(NumericVector x)
 {
-  return R_wrapper_double(x, &IN_AutoMutualInfoStats_diff_20_gaussian_ami8, 1);
+  return R_wrapper_double(x, &IN_AutoMutualInfoStats_diff_20_gaussian_ami8_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -594,7 +561,7 @@ NumericVector IN_AutoMutualInfoStats_diff_20_gaussian_ami8(NumericVector x)
 // [[Rcpp::export]]
 NumericVector CO_HistogramAMI_even_10_3(NumericVector x)
 {
-  return R_wrapper_double(x, &CO_HistogramAMI_even_10_3, 1);
+  return R_wrapper_double(x, &CO_HistogramAMI_even_10_3_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -610,7 +577,7 @@ NumericVector CO_HistogramAMI_even_10_3(NumericVector x)
 // [[Rcpp::export]]
 NumericVector CO_HistogramAMI_even_2_3(NumericVector x)
 {
-  return R_wrapper_double(x, &CO_HistogramAMI_even_2_3, 1);
+  return R_wrapper_double(x, &CO_HistogramAMI_even_2_3_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -626,7 +593,7 @@ NumericVector CO_HistogramAMI_even_2_3(NumericVector x)
 // [[Rcpp::export]]
 NumericVector CO_TranslateShape_circle_35_pts_statav4_m(NumericVector x)
 {
-  return R_wrapper_double(x, &CO_TranslateShape_circle_35_pts_statav4_m, 1);
+  return R_wrapper_double(x, &CO_TranslateShape_circle_35_pts_statav4_m_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -642,7 +609,7 @@ NumericVector CO_TranslateShape_circle_35_pts_statav4_m(NumericVector x)
 // [[Rcpp::export]]
 NumericVector CO_TranslateShape_circle_35_pts_std(NumericVector x)
 {
-  return R_wrapper_double(x, &CO_TranslateShape_circle_35_pts_std, 1);
+  return R_wrapper_double(x, &CO_TranslateShape_circle_35_pts_std_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -658,7 +625,7 @@ NumericVector CO_TranslateShape_circle_35_pts_std(NumericVector x)
 // [[Rcpp::export]]
 NumericVector DN_RemovePoints_absclose_05_ac2rat(NumericVector x)
 {
-  return R_wrapper_double(x, &DN_RemovePoints_absclose_05_ac2rat, 1);
+  return R_wrapper_double(x, &DN_RemovePoints_absclose_05_ac2rat_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -674,7 +641,7 @@ NumericVector DN_RemovePoints_absclose_05_ac2rat(NumericVector x)
 // [[Rcpp::export]]
 NumericVector FC_LoopLocalSimple_mean_stderr_chn(NumericVector x)
 {
-  return R_wrapper_double(x, &FC_LoopLocalSimple_mean_stderr_chn, 1);
+  return R_wrapper_double(x, &FC_LoopLocalSimple_mean_stderr_chn_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -690,7 +657,7 @@ NumericVector FC_LoopLocalSimple_mean_stderr_chn(NumericVector x)
 // [[Rcpp::export]]
 NumericVector PH_Walker_momentum_5_w_momentumzcross(NumericVector x)
 {
-  return R_wrapper_double(x, &PH_Walker_momentum_5_w_momentumzcross, 1);
+  return R_wrapper_double(x, &PH_Walker_momentum_5_w_momentumzcross_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -706,7 +673,7 @@ NumericVector PH_Walker_momentum_5_w_momentumzcross(NumericVector x)
 // [[Rcpp::export]]
 NumericVector PH_Walker_biasprop_05_01_sw_meanabsdiff(NumericVector x)
 {
-  return R_wrapper_double(x, &PH_Walker_biasprop_05_01_sw_meanabsdiff, 1);
+  return R_wrapper_double(x, &PH_Walker_biasprop_05_01_sw_meanabsdiff_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -722,7 +689,7 @@ NumericVector PH_Walker_biasprop_05_01_sw_meanabsdiff(NumericVector x)
 // [[Rcpp::export]]
 NumericVector ST_LocalExtrema_n100_diffmaxabsmin(NumericVector x)
 {
-  return R_wrapper_double(x, &ST_LocalExtrema_n100_diffmaxabsmin, 1);
+  return R_wrapper_double(x, &ST_LocalExtrema_n100_diffmaxabsmin_ctx, 1);
 }
 
 //' Function to calculate a statistical feature
@@ -738,7 +705,215 @@ NumericVector ST_LocalExtrema_n100_diffmaxabsmin(NumericVector x)
 // [[Rcpp::export]]
 NumericVector SC_FluctAnal_2_dfa_50_2_logi_r2_se2(NumericVector x)
 {
-  return R_wrapper_double(x, &SC_FluctAnal_2_dfa_50_2_logi_r2_se2, 1);
+  return R_wrapper_double(x, &SC_FluctAnal_2_dfa_50_2_logi_r2_se2_ctx, 1);
+}
+
+//-------------------------------------------------------------------------
+//----------------------- Feature sets ------------------------------------
+//-------------------------------------------------------------------------
+
+//' Function to calculate a whole feature set on a time series in a single call
+//'
+//' The series is z-scored once and intermediates such as the autocorrelation
+//' function are shared between all features of the set.
+//'
+//' @param x a numerical time-series input vector
+//' @param featureSet the feature set to compute. One of "catch22", "catchaMouse16" or "all"
+//' @param nThreads the number of threads features may use within the series. Only the rescaled-range fluctuation analysis of long series (at least 32768 samples) uses more than one. Ignored if the package was built without OpenMP
+//' @return named numeric vector of the calculated time-series statistics
+//' @author Trent Henderson
+//' @export
+//' @examples
+//' x <- 1 + 0.5 * 1:1000 + arima.sim(list(ma = 0.5), n = 1000)
+//' outs <- catch_features(x, "catch22")
+//'
+// [[Rcpp::export]]
+NumericVector catch_features(NumericVector x, std::string featureSet = "all", int nThreads = 1)
+{
+  int nFeatures = 0;
+  const feature_def * features = feature_set_lookup(featureSet.c_str(), &nFeatures);
+  if (features == NULL) {
+    stop("featureSet should be one of 'catch22', 'catchaMouse16' or 'all'");
+  }
+  if (nThreads < 1) {
+    stop("nThreads should be a positive integer");
+  }
+
+  NumericVector out(nFeatures);
+  CharacterVector names(nFeatures);
+
+  feature_context ctx;
+  context_init(&ctx, x.begin(), x.size(), 1);
+  context_set_threads(&ctx, nThreads);
+  feature_set_run(features, nFeatures, &ctx, out.begin());
+  context_free(&ctx);
+
+  for (int i = 0; i < nFeatures; i++) {
+    names[i] = features[i].name;
+  }
+  out.attr("names") = names;
+
+  return out;
+}
+
+//' Function to calculate the automutual information of a time series at
+//' several (bin count, lag) pairs in a single call
+//'
+//' The series is z-scored and binned once per distinct bin count, and the
+//' joint histogram of every lag is counted from the shared bin labels.
+//' CO_HistogramAMI_even_2_5 is the pair numBins = 5, tau = 2.
+//'
+//' @param x a numerical time-series input vector
+//' @param numBins integer vector of bin counts, each between 1 and 1000
+//' @param tau integer vector of lags, of the same length as numBins
+//' @return numeric vector of automutual information values, one per pair
+//' @author Trent Henderson
+//' @export
+//' @examples
+//' x <- 1 + 0.5 * 1:1000 + arima.sim(list(ma = 0.5), n = 1000)
+//' outs <- CO_HistogramAMI_even_multi(x, c(5, 10, 2, 10), c(2, 3, 3, 1))
+//'
+// [[Rcpp::export]]
+NumericVector CO_HistogramAMI_even_multi(NumericVector x, IntegerVector numBins, IntegerVector tau)
+{
+  if (numBins.size() != tau.size()) {
+    stop("numBins and tau should have the same length");
+  }
+  for (int k = 0; k < numBins.size(); k++) {
+    if (numBins[k] < 1 || numBins[k] > CO_HISTOGRAMAMI_MAX_BINS) {
+      stop("numBins should be between 1 and %d", CO_HISTOGRAMAMI_MAX_BINS);
+    }
+  }
+
+  NumericVector out(numBins.size());
+
+  feature_context ctx;
+  context_init(&ctx, x.begin(), x.size(), 1);
+  CO_HistogramAMI_even_multi_ctx(&ctx, numBins.begin(), tau.begin(), numBins.size(), out.begin());
+  context_free(&ctx);
+
+  return out;
+}
+
+//' Function to calculate the automutual information of a time series at
+//' increasing levels of added noise
+//'
+//' Gaussian noise from a fixed seed is added to the z-scored series at the
+//' 50 levels seq(0, 3, length.out = 50), and the automutual information
+//' (10 even bins, lag 1) is returned for each level.
+//' CO_AddNoise_1_even_10_ami_at_10 is the first level >= 1 of this curve.
+//'
+//' @param x a numerical time-series input vector
+//' @return numeric vector of 50 automutual information values, one per noise level
+//' @author Trent Henderson
+//' @export
+//' @examples
+//' x <- 1 + 0.5 * 1:1000 + arima.sim(list(ma = 0.5), n = 1000)
+//' outs <- CO_AddNoise_1_even_10_ami_curve(x)
+//'
+// [[Rcpp::export]]
+NumericVector CO_AddNoise_1_even_10_ami_curve(NumericVector x)
+{
+  NumericVector out(CO_ADDNOISE_NUM_LEVELS);
+
+  feature_context ctx;
+  context_init(&ctx, x.begin(), x.size(), 1);
+  CO_AddNoise_1_even_10_ami_curve_ctx(&ctx, out.begin());
+  context_free(&ctx);
+
+  return out;
+}
+
+//' Function to calculate the histogram mode of a time series at several
+//' histogram resolutions in a single call
+//'
+//' The z-scored series is counted into all requested numbers of bins in one
+//' pass; bin counts that are a power-of-two multiple of another are merged
+//' from the finer histogram. DN_HistogramMode_5 is nBins = 5.
+//'
+//' @param x a numerical time-series input vector
+//' @param nBins integer vector of numbers of bins, at least 1 and at most 1e6 in total
+//' @return numeric vector of histogram modes, one per number of bins
+//' @author Trent Henderson
+//' @export
+//' @examples
+//' x <- 1 + 0.5 * 1:1000 + arima.sim(list(ma = 0.5), n = 1000)
+//' outs <- DN_HistogramMode_multi(x, c(5, 10, 20, 40))
+//'
+// [[Rcpp::export]]
+NumericVector DN_HistogramMode_multi(NumericVector x, IntegerVector nBins)
+{
+  double total = 0;
+  for (int k = 0; k < nBins.size(); k++) {
+    if (nBins[k] < 1 || nBins[k] > DN_HISTOGRAMMODE_MAX_BINS) {
+      stop("nBins should be between 1 and %d", DN_HISTOGRAMMODE_MAX_BINS);
+    }
+    total += nBins[k];
+  }
+  if (total > DN_HISTOGRAMMODE_MAX_BINS) {
+    stop("nBins should sum to at most %d", DN_HISTOGRAMMODE_MAX_BINS);
+  }
+
+  NumericVector out(nBins.size());
+
+  feature_context ctx;
+  context_init(&ctx, x.begin(), x.size(), 1);
+  DN_HistogramMode_multi_ctx(&ctx, nBins.begin(), nBins.size(), out.begin());
+  context_free(&ctx);
+
+  return out;
+}
+
+//' Function to calculate the entropy of the Welch power spectrum of a time series
+//'
+//' The spectrum is the one SP_Summaries_welch_rect_area_5_1 and
+//' SP_Summaries_welch_rect_centroid are computed from, normalised to unit
+//' total power.
+//'
+//' @param x a numerical time-series input vector
+//' @return scalar value that denotes the calculated time-series statistic
+//' @author Trent Henderson
+//' @export
+//' @examples
+//' x <- 1 + 0.5 * 1:1000 + arima.sim(list(ma = 0.5), n = 1000)
+//' outs <- SP_Summaries_welch_rect_entropy(x)
+//'
+// [[Rcpp::export]]
+NumericVector SP_Summaries_welch_rect_entropy(NumericVector x)
+{
+  return R_wrapper_double(x, &SP_Summaries_welch_rect_entropy_ctx, 1);
+}
+
+//' Function to calculate the power of a time series in equal frequency bands
+//'
+//' The Welch power spectrum of the z-scored series is split into nBands
+//' bands of equally many frequency bins, lowest frequencies first.
+//' SP_Summaries_welch_rect_area_5_1 is the first of 5 bands.
+//'
+//' @param x a numerical time-series input vector
+//' @param nBands the number of bands
+//' @return numeric vector of the spectral power in each band
+//' @author Trent Henderson
+//' @export
+//' @examples
+//' x <- 1 + 0.5 * 1:1000 + arima.sim(list(ma = 0.5), n = 1000)
+//' outs <- SP_Summaries_welch_rect_bandpowers(x, 5)
+//'
+// [[Rcpp::export]]
+NumericVector SP_Summaries_welch_rect_bandpowers(NumericVector x, int nBands)
+{
+  if (nBands < 1) {
+    stop("nBands should be at least 1");
+  }
+
+  NumericVector out(nBands);
+
+  feature_context ctx;
+  context_init(&ctx, x.begin(), x.size(), 1);
+  SP_Summaries_welch_rect_bandpowers_ctx(&ctx, nBands, out.begin());
+  context_free(&ctx);
+
+  return out;
 }
 
 
@@ -0,0 +1,149 @@
+#include <Rcpp.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// include functions
+extern "C" {
+#include "feature_context.h"
+#include "feature_sets.h"
+#include "CO_AutoCorr.h"
+}
+
+using namespace Rcpp;
+
+//-------------------------------------------------------------------------
+//----------------------- Batch feature sets ------------------------------
+//-------------------------------------------------------------------------
+
+//' Function to calculate a whole feature set on many time series at once
+//'
+//' Every series is processed exactly as by \code{catch_features}, so results
+//' do not depend on the number of threads used.
+//'
+//' @param data a numeric matrix with one time series per column, or a list of numeric time-series vectors of possibly different lengths
+//' @param featureSet the feature set to compute. One of "catch22", "catchaMouse16" or "all"
+//' @param nThreads the number of threads to spread the series over. Ignored if the package was built without OpenMP
+//' @return numeric matrix with one row per time series and one column per feature
+//' @author Trent Henderson
+//' @export
+//' @examples
+//' x <- replicate(10, 1 + 0.5 * 1:1000 + arima.sim(list(ma = 0.5), n = 1000))
+//' outs <- catch_features_batch(x, "catch22", nThreads = 2)
+//'
+// [[Rcpp::export]]
+NumericMatrix catch_features_batch(SEXP data, std::string featureSet = "all", int nThreads = 1)
+{
+  int nFeatures = 0;
+  const feature_def * features = feature_set_lookup(featureSet.c_str(), &nFeatures);
+  if (features == NULL) {
+    stop("featureSet should be one of 'catch22', 'catchaMouse16' or 'all'");
+  }
+  if (nThreads < 1) {
+    stop("nThreads should be a positive integer");
+  }
+
+  // collect pointers to every series up front; the R API must not be
+  // touched from the worker threads
+  std::vector<const double *> series;
+  std::vector<int> sizes;
+  List seriesList;
+  SEXP rowNames = R_NilValue;
+
+  if (Rf_isMatrix(data)) {
+    NumericMatrix mat(data);
+    series.resize(mat.ncol());
+    sizes.assign(mat.ncol(), mat.nrow());
+    for (int s = 0; s < mat.ncol(); s++) {
+      series[s] = mat.begin() + (R_xlen_t) s * mat.nrow();
+    }
+    SEXP dimnames = Rf_getAttrib(mat, R_DimNamesSymbol);
+    if (!Rf_isNull(dimnames)) {
+      rowNames = VECTOR_ELT(dimnames, 1);
+    }
+    seriesList = List::create(mat);
+  } else if (Rf_isNewList(data)) {
+    List in(data);
+    seriesList = List(in.size());
+    series.resize(in.size());
+    sizes.resize(in.size());
+    for (int s = 0; s < in.size(); s++) {
+      NumericVector x = as<NumericVector>(in[s]);
+      seriesList[s] = x;
+      series[s] = x.begin();
+      sizes[s] = x.size();
+    }
+    rowNames = in.names();
+  } else {
+    stop("data should be a numeric matrix or a list of numeric vectors");
+  }
+
+  const int nSeries = series.size();
+  NumericMatrix out(nSeries, nFeatures);
+  double * outData = out.begin();
+
+  // series are handed to the threads in blocks, so that runs of equal
+  // length within a block can share one batched autocorrelation transform
+  const int blockSize = 8;
+  const int nBlocks = (nSeries + blockSize - 1) / blockSize;
+
+#ifdef _OPENMP
+  #pragma omp parallel num_threads(nThreads)
+#endif
+  {
+    std::vector<double> values(nFeatures);
+    feature_context ctx[blockSize];
+    const double * ys[blockSize];
+    double * autocorrs[blockSize];
+
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int blk = 0; blk < nBlocks; blk++) {
+      const int first = blk * blockSize;
+      const int last = std::min(first + blockSize, nSeries);
+
+      for (int s = first; s < last; s++) {
+        context_init(&ctx[s - first], series[s], sizes[s], 1);
+      }
+
+      for (int s = first; s < last; ) {
+        int e = s + 1;
+        while (e < last && sizes[e] == sizes[s]) {
+          e++;
+        }
+        if (e - s > 1 && sizes[s] > 1) {
+          for (int i = s; i < e; i++) {
+            ys[i - s] = context_y(&ctx[i - first]);
+          }
+          co_autocorrs_batch(ys, e - s, sizes[s], autocorrs);
+          for (int i = s; i < e; i++) {
+            context_set_autocorrs(&ctx[i - first], autocorrs[i - s]);
+          }
+        }
+        s = e;
+      }
+
+      for (int s = first; s < last; s++) {
+        feature_set_run(features, nFeatures, &ctx[s - first], values.data());
+        context_free(&ctx[s - first]);
+
+        for (int i = 0; i < nFeatures; i++) {
+          outData[s + (R_xlen_t) i * nSeries] = values[i];
+        }
+      }
+    }
+  }
+
+  CharacterVector colNames(nFeatures);
+  for (int i = 0; i < nFeatures; i++) {
+    colNames[i] = features[i].name;
+  }
+  out.attr("dimnames") = List::create(rowNames, colNames);
+
+  return out;
+}
@@ -0,0 +1,272 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "feature_context.h"
+#include "stats.h"
+#include "helper_functions.h"
+#include "CO_AutoCorr.h"
+#include "SC_FluctAnal.h"
+#include "SP_Summaries.h"
+
+void context_init(feature_context * ctx, const double y[], const int size, const int normalize)
+{
+    ctx->raw = y;
+    ctx->size = size;
+    ctx->normalize = normalize;
+    ctx->nThreads = 1;
+
+    ctx->zscored = NULL;
+    ctx->nanFlag = -1;
+    ctx->haveMoments = 0;
+    ctx->haveStd = 0;
+    ctx->diff = NULL;
+    ctx->centered = NULL;
+    ctx->nAcfDirect = 0;
+    ctx->autocorrs = NULL;
+    ctx->firstzero = -1;
+    ctx->sorted = NULL;
+    ctx->cumsum = NULL;
+    ctx->haveHistogramMode = 0;
+    ctx->haveOutlierInclude = 0;
+    ctx->fluct = NULL;
+    ctx->welch = NULL;
+    for (int k = 0; k < CONTEXT_AMI_LABEL_SLOTS; k++) {
+        ctx->amiLabelBins[k] = 0;
+        ctx->amiLabels[k] = NULL;
+    }
+}
+
+void context_free(feature_context * ctx)
+{
+    free(ctx->zscored);
+    free(ctx->diff);
+    free(ctx->centered);
+    free(ctx->autocorrs);
+    free(ctx->sorted);
+    free(ctx->cumsum);
+    fluct_analysis_free(ctx->fluct);
+    welch_spectrum_free(ctx->welch);
+    for (int k = 0; k < CONTEXT_AMI_LABEL_SLOTS; k++) {
+        free(ctx->amiLabels[k]);
+    }
+
+    int nThreads = ctx->nThreads;
+    context_init(ctx, ctx->raw, ctx->size, ctx->normalize);
+    ctx->nThreads = nThreads;
+}
+
+void context_set_threads(feature_context * ctx, const int nThreads)
+{
+    ctx->nThreads = nThreads > 1 ? nThreads : 1;
+}
+
+// the series all features operate on
+const double * context_y(feature_context * ctx)
+{
+    if (!ctx->normalize) {
+        return ctx->raw;
+    }
+    if (ctx->zscored == NULL) {
+        ctx->zscored = malloc(ctx->size * sizeof(double));
+        zscore_norm2(ctx->raw, ctx->size, ctx->zscored);
+    }
+    return ctx->zscored;
+}
+
+int context_has_nan(feature_context * ctx)
+{
+    if (ctx->nanFlag < 0) {
+        const double * y = context_y(ctx);
+        ctx->nanFlag = 0;
+        for (int i = 0; i < ctx->size; i++) {
+            if (isnan(y[i])) {
+                ctx->nanFlag = 1;
+                break;
+            }
+        }
+    }
+    return ctx->nanFlag;
+}
+
+// min, max and mean in one pass; same order of operations as min_, max_ and mean
+static void context_moments(feature_context * ctx)
+{
+    if (ctx->haveMoments) {
+        return;
+    }
+    const double * y = context_y(ctx);
+    double lo = y[0], hi = y[0], s = 0.0;
+    for (int i = 0; i < ctx->size; i++) {
+        if (y[i] < lo) {
+            lo = y[i];
+        }
+        if (y[i] > hi) {
+            hi = y[i];
+        }
+        s += y[i];
+    }
+    ctx->minVal = lo;
+    ctx->maxVal = hi;
+    ctx->meanVal = s / ctx->size;
+    ctx->haveMoments = 1;
+}
+
+double context_min(feature_context * ctx)
+{
+    context_moments(ctx);
+    return ctx->minVal;
+}
+
+double context_max(feature_context * ctx)
+{
+    context_moments(ctx);
+    return ctx->maxVal;
+}
+
+double context_mean(feature_context * ctx)
+{
+    context_moments(ctx);
+    return ctx->meanVal;
+}
+
+double context_std(feature_context * ctx)
+{
+    if (!ctx->haveStd) {
+        ctx->stdVal = stddev(context_y(ctx), ctx->size);
+        ctx->haveStd = 1;
+    }
+    return ctx->stdVal;
+}
+
+const double * context_diff(feature_context * ctx)
+{
+    if (ctx->diff == NULL) {
+        ctx->diff = malloc((ctx->size - 1) * sizeof(double));
+        diff(context_y(ctx), ctx->size, ctx->diff);
+    }
+    return ctx->diff;
+}
+
+const double * context_centered(feature_context * ctx)
+{
+    if (ctx->centered == NULL) {
+        const double * y = context_y(ctx);
+        double m = mean(y, ctx->size);
+        ctx->centered = malloc(ctx->size * sizeof(double));
+        for (int i = 0; i < ctx->size; i++) {
+            ctx->centered[i] = y[i] - m;
+        }
+    }
+    return ctx->centered;
+}
+
+// fill acfDirect up to (at least) lag, a block of lags at a time
+static void context_acf_direct(feature_context * ctx, const int lag)
+{
+    const int size = ctx->size;
+    const int nDirect = size < CONTEXT_ACF_DIRECT_LAGS ? size : CONTEXT_ACF_DIRECT_LAGS;
+
+    const double * centered = context_centered(ctx);
+
+    while (ctx->nAcfDirect <= lag && ctx->nAcfDirect < nDirect) {
+        int first = ctx->nAcfDirect;
+        int nLags = nDirect - first < CO_LAG_BLOCK ? nDirect - first : CO_LAG_BLOCK;
+        co_lag_products(centered, size, first, nLags, ctx->acfDirect + first);
+        ctx->nAcfDirect += nLags;
+    }
+}
+
+// lag 0 sum, which normalises the direct lags
+static double context_acf_var(feature_context * ctx)
+{
+    context_acf_direct(ctx, 0);
+    return ctx->acfDirect[0];
+}
+
+double context_lag_product(feature_context * ctx, const int lag)
+{
+    if (lag < CONTEXT_ACF_DIRECT_LAGS) {
+        context_acf_direct(ctx, lag);
+        return ctx->acfDirect[lag];
+    }
+    double out;
+    co_lag_products(context_centered(ctx), ctx->size, lag, 1, &out);
+    return out;
+}
+
+double context_acf(feature_context * ctx, const int lag)
+{
+    if (lag >= ctx->size) {
+        return 0;
+    }
+    if (lag < CONTEXT_ACF_DIRECT_LAGS) {
+        context_acf_direct(ctx, lag);
+        return ctx->acfDirect[lag] / context_acf_var(ctx);
+    }
+    return context_autocorrs(ctx)[lag];
+}
+
+// overwrite the leading lags of a full FFT autocorrelation with the direct
+// values, so both access paths agree
+static void context_patch_autocorrs(feature_context * ctx)
+{
+    const int nDirect = ctx->size < CONTEXT_ACF_DIRECT_LAGS ? ctx->size : CONTEXT_ACF_DIRECT_LAGS;
+    for (int lag = 0; lag < nDirect; lag++) {
+        ctx->autocorrs[lag] = context_acf(ctx, lag);
+    }
+}
+
+const double * context_autocorrs(feature_context * ctx)
+{
+    if (ctx->autocorrs == NULL) {
+        ctx->autocorrs = co_autocorrs(context_y(ctx), ctx->size);
+        context_patch_autocorrs(ctx);
+    }
+    return ctx->autocorrs;
+}
+
+void context_set_autocorrs(feature_context * ctx, double * autocorrs)
+{
+    free(ctx->autocorrs);
+    ctx->autocorrs = autocorrs;
+    context_patch_autocorrs(ctx);
+    ctx->firstzero = -1;
+}
+
+int context_firstzero_max(feature_context * ctx, const int maxtau)
+{
+    int zerocrossind = 0;
+    while(context_acf(ctx, zerocrossind) > 0 && zerocrossind < maxtau)
+    {
+        zerocrossind += 1;
+    }
+    return zerocrossind;
+}
+
+int context_firstzero(feature_context * ctx)
+{
+    if (ctx->firstzero < 0) {
+        ctx->firstzero = context_firstzero_max(ctx, ctx->size);
+    }
+    return ctx->firstzero;
+}
+
+const double * context_sorted(feature_context * ctx)
+{
+    if (ctx->sorted == NULL) {
+        ctx->sorted = malloc(ctx->size * sizeof(double));
+        memcpy(ctx->sorted, context_y(ctx), ctx->size * sizeof(double));
+        sort(ctx->sorted, ctx->size);
+    }
+    return ctx->sorted;
+}
+
+const double * context_cumsum(feature_context * ctx)
+{
+    if (ctx->cumsum == NULL) {
+        ctx->cumsum = malloc(ctx->size * sizeof(double));
+        cumsum(context_y(ctx), ctx->size, ctx->cumsum);
+    }
+    return ctx->cumsum;
+}
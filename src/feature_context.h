@@ -0,0 +1,82 @@
+#ifndef FEATURE_CONTEXT_H
+#define FEATURE_CONTEXT_H
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Autocorrelations at lags below this are always taken from direct sums
+// (computed a block of lags at a time, on demand); larger lags come from
+// one FFT of the whole series. Which method serves a lag never depends on
+// what was requested before, so results do not depend on feature order.
+#define CONTEXT_ACF_DIRECT_LAGS 40
+
+// number of CO_HistogramAMI bin labellings the context keeps
+#define CONTEXT_AMI_LABEL_SLOTS 4
+
+struct fluct_analysis;
+struct welch_spectrum;
+
+// per-series state shared by all features. Intermediates are computed on
+// first request and kept until context_free, so features evaluated on the
+// same series never redo the z-scoring, NaN scan, ACF, diff or sort.
+typedef struct feature_context {
+    const double * raw;     // input as handed over by the caller (not owned)
+    int size;
+    int normalize;          // z-score raw before handing it to features?
+    int nThreads;           // threads a single feature may use, 1 by default
+
+    double * zscored;       // owned, only used if normalize
+    int nanFlag;            // -1 if not yet checked
+    int haveMoments, haveStd;
+    double minVal, maxVal, meanVal, stdVal;
+    double * diff;          // size-1 first differences
+    double * centered;      // mean-removed series for direct autocorrelation sums
+    double acfDirect[CONTEXT_ACF_DIRECT_LAGS];
+    int nAcfDirect;         // leading lags of acfDirect filled so far
+    double * autocorrs;     // FFT autocorrelation, as returned by co_autocorrs
+    int firstzero;          // -1 if not yet computed
+    double * sorted;        // ascending copy of the series
+    double * cumsum;
+    int haveHistogramMode;
+    double histogramMode[2];        // DN_HistogramMode 5 and 10
+    int haveOutlierInclude;
+    double outlierInclude[2];       // DN_OutlierInclude p and n variants
+    struct fluct_analysis * fluct;  // SC_FluctAnal scales and fluctuation functions
+    struct welch_spectrum * welch;  // SP_Summaries power spectrum
+    int amiLabelBins[CONTEXT_AMI_LABEL_SLOTS];  // bin count per slot, 0 if free
+    int * amiLabels[CONTEXT_AMI_LABEL_SLOTS];   // CO_HistogramAMI bin of every sample
+} feature_context;
+
+extern void context_init(feature_context * ctx, const double y[], const int size, const int normalize);
+extern void context_free(feature_context * ctx);
+// let features spread their own work over nThreads OpenMP threads (only
+// worthwhile for a single long series; results do not depend on it)
+extern void context_set_threads(feature_context * ctx, const int nThreads);
+
+extern const double * context_y(feature_context * ctx);
+extern int context_has_nan(feature_context * ctx);
+extern double context_min(feature_context * ctx);
+extern double context_max(feature_context * ctx);
+extern double context_mean(feature_context * ctx);
+extern double context_std(feature_context * ctx);
+extern const double * context_diff(feature_context * ctx);
+// series minus its mean
+extern const double * context_centered(feature_context * ctx);
+// sum_i c[i] c[i + lag] of the centered series c (lag < size)
+extern double context_lag_product(feature_context * ctx, const int lag);
+// autocorrelation at a single lag (0 for lags >= size)
+extern double context_acf(feature_context * ctx, const int lag);
+// all lags 0..size-1, as a vector of fft_next_size(2 size - 1) entries;
+// that is at least size + 1 only for size > 1, and the entries past
+// size - 1 are FFT padding, not autocorrelations
+extern const double * context_autocorrs(feature_context * ctx);
+// hand over an autocorrelation computed elsewhere (e.g. by
+// co_autocorrs_batch); the context takes ownership
+extern void context_set_autocorrs(feature_context * ctx, double * autocorrs);
+extern int context_firstzero(feature_context * ctx);
+// first lag with non-positive autocorrelation, searched up to maxtau
+extern int context_firstzero_max(feature_context * ctx, const int maxtau);
+extern const double * context_sorted(feature_context * ctx);
+extern const double * context_cumsum(feature_context * ctx);
+
+#endif
@@ -0,0 +1,112 @@
+#include <string.h>
+
+#include "feature_sets.h"
+#include "CO_AutoCorr.h"
+#include "DN_HistogramMode_10.h"
+#include "DN_HistogramMode_5.h"
+#include "DN_OutlierInclude.h"
+#include "FC_LocalSimple.h"
+#include "IN_AutoMutualInfoStats.h"
+#include "MD_hrv.h"
+#include "PD_PeriodicityWang.h"
+#include "SB_BinaryStats.h"
+#include "SB_MotifThree.h"
+#include "SB_TransitionMatrix.h"
+#include "SC_FluctAnal.h"
+#include "SP_Summaries.h"
+#include "SY_DriftingMean.h"
+#include "CO_AddNoise.h"
+#include "CO_NonlinearAutocorr.h"
+#include "CO_HistogramAMI.h"
+#include "CO_TranslateShape.h"
+#include "DN_RemovePoints.h"
+#include "PH_Walker.h"
+#include "ST_LocalExtrema.h"
+
+// integer-valued features, widened the same way the R wrappers do
+static double CO_f1ecac_dbl(feature_context * ctx)
+{
+    return CO_f1ecac_ctx(ctx);
+}
+
+static double CO_FirstMin_ac_dbl(feature_context * ctx)
+{
+    return CO_FirstMin_ac_ctx(ctx);
+}
+
+static double PD_PeriodicityWang_th0_01_dbl(feature_context * ctx)
+{
+    return PD_PeriodicityWang_th0_01_ctx(ctx);
+}
+
+const feature_def all_features[] = {
+    // catch22
+    {"DN_HistogramMode_5", &DN_HistogramMode_5_ctx},
+    {"DN_HistogramMode_10", &DN_HistogramMode_10_ctx},
+    {"CO_f1ecac", &CO_f1ecac_dbl},
+    {"CO_FirstMin_ac", &CO_FirstMin_ac_dbl},
+    {"CO_HistogramAMI_even_2_5", &CO_HistogramAMI_even_2_5_ctx},
+    {"CO_trev_1_num", &CO_trev_1_num_ctx},
+    {"MD_hrv_classic_pnn40", &MD_hrv_classic_pnn40_ctx},
+    {"SB_BinaryStats_mean_longstretch1", &SB_BinaryStats_mean_longstretch1_ctx},
+    {"SB_TransitionMatrix_3ac_sumdiagcov", &SB_TransitionMatrix_3ac_sumdiagcov_ctx},
+    {"PD_PeriodicityWang_th0_01", &PD_PeriodicityWang_th0_01_dbl},
+    {"CO_Embed2_Dist_tau_d_expfit_meandiff", &CO_Embed2_Dist_tau_d_expfit_meandiff_ctx},
+    {"IN_AutoMutualInfoStats_40_gaussian_fmmi", &IN_AutoMutualInfoStats_40_gaussian_fmmi_ctx},
+    {"FC_LocalSimple_mean1_tauresrat", &FC_LocalSimple_mean1_tauresrat_ctx},
+    {"DN_OutlierInclude_p_001_mdrmd", &DN_OutlierInclude_p_001_mdrmd_ctx},
+    {"DN_OutlierInclude_n_001_mdrmd", &DN_OutlierInclude_n_001_mdrmd_ctx},
+    {"SP_Summaries_welch_rect_area_5_1", &SP_Summaries_welch_rect_area_5_1_ctx},
+    {"SB_BinaryStats_diff_longstretch0", &SB_BinaryStats_diff_longstretch0_ctx},
+    {"SB_MotifThree_quantile_hh", &SB_MotifThree_quantile_hh_ctx},
+    {"SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1", &SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1_ctx},
+    {"SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1", &SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1_ctx},
+    {"SP_Summaries_welch_rect_centroid", &SP_Summaries_welch_rect_centroid_ctx},
+    {"FC_LocalSimple_mean3_stderr", &FC_LocalSimple_mean3_stderr_ctx},
+    // catchaMouse16
+    {"SY_DriftingMean50_min", &SY_DriftingMean50_min_ctx},
+    {"CO_AddNoise_1_even_10_ami_at_10", &CO_AddNoise_1_even_10_ami_at_10_ctx},
+    {"AC_nl_036", &AC_nl_036_ctx},
+    {"AC_nl_035", &AC_nl_035_ctx},
+    {"AC_nl_112", &AC_nl_112_ctx},
+    {"IN_AutoMutualInfoStats_diff_20_gaussian_ami8", &IN_AutoMutualInfoStats_diff_20_gaussian_ami8_ctx},
+    {"CO_HistogramAMI_even_10_3", &CO_HistogramAMI_even_10_3_ctx},
+    {"CO_HistogramAMI_even_2_3", &CO_HistogramAMI_even_2_3_ctx},
+    {"CO_TranslateShape_circle_35_pts_statav4_m", &CO_TranslateShape_circle_35_pts_statav4_m_ctx},
+    {"CO_TranslateShape_circle_35_pts_std", &CO_TranslateShape_circle_35_pts_std_ctx},
+    {"DN_RemovePoints_absclose_05_ac2rat", &DN_RemovePoints_absclose_05_ac2rat_ctx},
+    {"FC_LoopLocalSimple_mean_stderr_chn", &FC_LoopLocalSimple_mean_stderr_chn_ctx},
+    {"PH_Walker_momentum_5_w_momentumzcross", &PH_Walker_momentum_5_w_momentumzcross_ctx},
+    {"PH_Walker_biasprop_05_01_sw_meanabsdiff", &PH_Walker_biasprop_05_01_sw_meanabsdiff_ctx},
+    {"ST_LocalExtrema_n100_diffmaxabsmin", &ST_LocalExtrema_n100_diffmaxabsmin_ctx},
+    {"SC_FluctAnal_2_dfa_50_2_logi_r2_se2", &SC_FluctAnal_2_dfa_50_2_logi_r2_se2_ctx}
+};
+
+const int n_catch22_features = 22;
+const int n_catchaMouse16_features = 16;
+const int n_all_features = sizeof(all_features) / sizeof(all_features[0]);
+
+const feature_def * feature_set_lookup(const char * set, int * nFeatures)
+{
+    if (strcmp(set, "all") == 0) {
+        *nFeatures = n_all_features;
+        return all_features;
+    }
+    if (strcmp(set, "catch22") == 0) {
+        *nFeatures = n_catch22_features;
+        return all_features;
+    }
+    if (strcmp(set, "catchaMouse16") == 0) {
+        *nFeatures = n_catchaMouse16_features;
+        return all_features + n_catch22_features;
+    }
+    *nFeatures = 0;
+    return NULL;
+}
+
+void feature_set_run(const feature_def * features, const int nFeatures, feature_context * ctx, double * out)
+{
+    for (int i = 0; i < nFeatures; i++) {
+        out[i] = features[i].fn(ctx);
+    }
+}
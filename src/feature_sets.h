@@ -0,0 +1,25 @@
+#ifndef FEATURE_SETS_H
+#define FEATURE_SETS_H
+#include "feature_context.h"
+
+// a feature as seen by the native drivers: its name and an entry point
+// reading from a per-series context
+typedef struct feature_def {
+    const char * name;
+    double (*fn)(feature_context * ctx);
+} feature_def;
+
+// all features, catch22 first followed by catchaMouse16, in the order
+// the R front ends report them
+extern const feature_def all_features[];
+extern const int n_all_features;
+extern const int n_catch22_features;
+extern const int n_catchaMouse16_features;
+
+// "catch22", "catchaMouse16" or "all"; returns NULL for an unknown set
+extern const feature_def * feature_set_lookup(const char * set, int * nFeatures);
+
+// evaluate nFeatures features on one context, writing into out
+extern void feature_set_run(const feature_def * features, const int nFeatures, feature_context * ctx, double * out);
+
+#endif
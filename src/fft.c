@@ -2,60 +2,505 @@
 #include <string.h>
 #include <math.h>
 
-#if __cplusplus
-#   include <complex>
-typedef std::complex< double > cplx;
-#else
-#   include <complex.h>
-#if defined(__GNUC__) || defined(__GNUG__)
-typedef double complex cplx;
-#elif defined(_MSC_VER)
-typedef _Dcomplex cplx;
+#include "fft.h"
+
+#define FFT_PI 3.14159265358979323846
+
+// at most this many plans are kept alive by the cache
+#define FFT_PLAN_CACHE_SIZE 16
+
+static int is_smooth(int n)
+{
+    while (n % 2 == 0) n /= 2;
+    while (n % 3 == 0) n /= 3;
+    while (n % 5 == 0) n /= 5;
+    return n == 1;
+}
+
+int fft_next_size(const int n)
+{
+    if (n <= 1) {
+        return 1;
+    }
+    int half = (n + 1) / 2;
+    while (!is_smooth(half)) {
+        half++;
+    }
+    return 2 * half;
+}
+
+fft_plan * fft_plan_create(const int size)
+{
+    fft_plan * plan = malloc(sizeof(fft_plan));
+    plan->size = size;
+    plan->half = size / 2;
+    plan->refs = 0;
+    plan->cached = 0;
+    plan->lastUse = 0;
+
+    const int half = plan->half;
+
+    // factorise into radix 4 stages first, then 2, 3 and 5
+    int rest = half > 0 ? half : 1;
+    plan->nStages = 0;
+    while (rest % 4 == 0) {
+        plan->radix[plan->nStages++] = 4;
+        rest /= 4;
+    }
+    const int radices[] = {2, 3, 5};
+    for (int i = 0; i < 3; i++) {
+        while (rest % radices[i] == 0) {
+            plan->radix[plan->nStages++] = radices[i];
+            rest /= radices[i];
+        }
+    }
+
+    // digit-reversal permutation matching the stage order: the last stage
+    // splits the input into radix[nStages-1] interleaved subsequences
+    plan->perm = malloc((half > 0 ? half : 1) * sizeof(int));
+    for (int i = 0; i < half; i++) {
+        int r = i, pos = 0, m = half;
+        for (int t = plan->nStages - 1; t >= 0; t--) {
+            m /= plan->radix[t];
+            pos += (r % plan->radix[t]) * m;
+            r /= plan->radix[t];
+        }
+        plan->perm[pos] = i;
+    }
+
+    // butterfly twiddles exp(-2 pi i q k / (span * radix)), contiguous per
+    // stage and leg q so the loop over k runs over consecutive entries
+    int nTw = 0, span = 1;
+    for (int t = 0; t < plan->nStages; t++) {
+        plan->span[t] = span;
+        plan->twOffset[t] = nTw;
+        nTw += (plan->radix[t] - 1) * span;
+        span *= plan->radix[t];
+    }
+    plan->twRe = malloc((nTw > 0 ? nTw : 1) * sizeof(double));
+    plan->twIm = malloc((nTw > 0 ? nTw : 1) * sizeof(double));
+    for (int t = 0; t < plan->nStages; t++) {
+        int L = plan->span[t], r = plan->radix[t];
+        for (int q = 1; q < r; q++) {
+            for (int k = 0; k < L; k++) {
+                double phi = -2 * FFT_PI * q * k / (L * r);
+                plan->twRe[plan->twOffset[t] + (q - 1) * L + k] = cos(phi);
+                plan->twIm[plan->twOffset[t] + (q - 1) * L + k] = sin(phi);
+            }
+        }
+    }
+
+    // twiddles recombining the even/odd half-length transform
+    plan->splitRe = malloc((half / 2 + 1) * sizeof(double));
+    plan->splitIm = malloc((half / 2 + 1) * sizeof(double));
+    for (int k = 0; k <= half / 2; k++) {
+        double phi = -2 * FFT_PI * k / size;
+        plan->splitRe[k] = cos(phi);
+        plan->splitIm[k] = sin(phi);
+    }
+
+    return plan;
+}
+
+void fft_plan_free(fft_plan * plan)
+{
+    if (plan == NULL) {
+        return;
+    }
+    free(plan->perm);
+    free(plan->twRe);
+    free(plan->twIm);
+    free(plan->splitRe);
+    free(plan->splitIm);
+    free(plan);
+}
+
+// Plan cache. All bookkeeping happens inside one named critical section;
+// without OpenMP the pragmas are ignored and everything runs on one thread.
+static fft_plan * planCache[FFT_PLAN_CACHE_SIZE];
+static unsigned long planCacheClock = 0;
+
+fft_plan * fft_plan_acquire(const int size)
+{
+    fft_plan * plan = NULL;
+
+#ifdef _OPENMP
+    #pragma omp critical(fft_plan_cache)
 #endif
+    {
+        for (int i = 0; i < FFT_PLAN_CACHE_SIZE; i++) {
+            if (planCache[i] != NULL && planCache[i]->size == size) {
+                plan = planCache[i];
+                plan->refs++;
+                plan->lastUse = ++planCacheClock;
+                break;
+            }
+        }
+    }
+    if (plan != NULL) {
+        return plan;
+    }
+
+    // build outside the lock so other sizes are not held up
+    fft_plan * fresh = fft_plan_create(size);
+    fft_plan * evicted = NULL;
+
+#ifdef _OPENMP
+    #pragma omp critical(fft_plan_cache)
 #endif
+    {
+        // another thread may have inserted the same size meanwhile
+        for (int i = 0; i < FFT_PLAN_CACHE_SIZE; i++) {
+            if (planCache[i] != NULL && planCache[i]->size == size) {
+                plan = planCache[i];
+                break;
+            }
+        }
+        if (plan == NULL) {
+            // take an empty slot, else evict the least recently used plan
+            int slot = 0;
+            for (int i = 0; i < FFT_PLAN_CACHE_SIZE; i++) {
+                if (planCache[i] == NULL) {
+                    slot = i;
+                    break;
+                }
+                if (planCache[i]->lastUse < planCache[slot]->lastUse) {
+                    slot = i;
+                }
+            }
+            if (planCache[slot] != NULL) {
+                planCache[slot]->cached = 0;
+                if (planCache[slot]->refs == 0) {
+                    evicted = planCache[slot];
+                }
+            }
+            fresh->cached = 1;
+            planCache[slot] = fresh;
+            plan = fresh;
+            fresh = NULL;
+        }
+        plan->refs++;
+        plan->lastUse = ++planCacheClock;
+    }
 
-#ifndef CMPLX
-#define CMPLX(x, y) ((cplx)((double)(x) + _Imaginary_I * (double)(y)))
+    fft_plan_free(fresh);
+    fft_plan_free(evicted);
+    return plan;
+}
+
+void fft_plan_release(fft_plan * plan)
+{
+    int drop = 0;
+
+#ifdef _OPENMP
+    #pragma omp critical(fft_plan_cache)
 #endif
+    {
+        plan->refs--;
+        drop = (plan->refs == 0 && !plan->cached);
+    }
 
-#include "helper_functions.h"
+    // evicted while in use: the last user frees it
+    if (drop) {
+        fft_plan_free(plan);
+    }
+}
 
-void twiddles(cplx a[], int size)
+void fft_plan_cache_clear(void)
 {
+    fft_plan * unused[FFT_PLAN_CACHE_SIZE];
+    int nUnused = 0;
 
-    double PI = 3.14159265359;
+#ifdef _OPENMP
+    #pragma omp critical(fft_plan_cache)
+#endif
+    {
+        for (int i = 0; i < FFT_PLAN_CACHE_SIZE; i++) {
+            if (planCache[i] == NULL) {
+                continue;
+            }
+            planCache[i]->cached = 0;
+            if (planCache[i]->refs == 0) {
+                unused[nUnused++] = planCache[i];
+            }
+            planCache[i] = NULL;
+        }
+    }
+
+    for (int i = 0; i < nUnused; i++) {
+        fft_plan_free(unused[i]);
+    }
+}
+
+// Forward complex transform of length plan->half on digit-reversed input,
+// in place, split layout, for count interleaved series: element k of
+// series j lives at index k * count + j. Each stage combines radix
+// sub-transforms of length L into one of length L * radix; the innermost
+// loops run over the series so they vectorize for count > 1.
+static void fft_stages(const fft_plan * plan, const int count, double re[], double im[])
+{
+    const int n = plan->half;
+
+    for (int t = 0; t < plan->nStages; t++) {
+        const int L = plan->span[t];
+        const int r = plan->radix[t];
+        const int stride = L * count;
+        const double * wRe = plan->twRe + plan->twOffset[t];
+        const double * wIm = plan->twIm + plan->twOffset[t];
+
+        for (int b = 0; b < n; b += L * r) {
+            for (int k = 0; k < L; k++) {
+                double * xRe = re + (b + k) * count;
+                double * xIm = im + (b + k) * count;
+
+                if (r == 2) {
+                    const double w1Re = wRe[k], w1Im = wIm[k];
+                    for (int j = 0; j < count; j++) {
+                        double aRe = xRe[j], aIm = xIm[j];
+                        double bRe = xRe[j + stride] * w1Re - xIm[j + stride] * w1Im;
+                        double bIm = xRe[j + stride] * w1Im + xIm[j + stride] * w1Re;
+                        xRe[j] = aRe + bRe;
+                        xIm[j] = aIm + bIm;
+                        xRe[j + stride] = aRe - bRe;
+                        xIm[j + stride] = aIm - bIm;
+                    }
+                }
+                else if (r == 4) {
+                    const double w1Re = wRe[k], w1Im = wIm[k];
+                    const double w2Re = wRe[L + k], w2Im = wIm[L + k];
+                    const double w3Re = wRe[2 * L + k], w3Im = wIm[2 * L + k];
+                    for (int j = 0; j < count; j++) {
+                        double a0Re = xRe[j], a0Im = xIm[j];
+                        double a1Re = xRe[j + stride] * w1Re - xIm[j + stride] * w1Im;
+                        double a1Im = xRe[j + stride] * w1Im + xIm[j + stride] * w1Re;
+                        double a2Re = xRe[j + 2 * stride] * w2Re - xIm[j + 2 * stride] * w2Im;
+                        double a2Im = xRe[j + 2 * stride] * w2Im + xIm[j + 2 * stride] * w2Re;
+                        double a3Re = xRe[j + 3 * stride] * w3Re - xIm[j + 3 * stride] * w3Im;
+                        double a3Im = xRe[j + 3 * stride] * w3Im + xIm[j + 3 * stride] * w3Re;
+
+                        double s02Re = a0Re + a2Re, s02Im = a0Im + a2Im;
+                        double d02Re = a0Re - a2Re, d02Im = a0Im - a2Im;
+                        double s13Re = a1Re + a3Re, s13Im = a1Im + a3Im;
+                        double d13Re = a1Re - a3Re, d13Im = a1Im - a3Im;
+
+                        // y1 = d02 - i d13, y3 = d02 + i d13
+                        xRe[j] = s02Re + s13Re;
+                        xIm[j] = s02Im + s13Im;
+                        xRe[j + stride] = d02Re + d13Im;
+                        xIm[j + stride] = d02Im - d13Re;
+                        xRe[j + 2 * stride] = s02Re - s13Re;
+                        xIm[j + 2 * stride] = s02Im - s13Im;
+                        xRe[j + 3 * stride] = d02Re - d13Im;
+                        xIm[j + 3 * stride] = d02Im + d13Re;
+                    }
+                }
+                else if (r == 3) {
+                    const double s60 = 0.86602540378443864676; // sin(2 pi / 3)
+                    const double w1Re = wRe[k], w1Im = wIm[k];
+                    const double w2Re = wRe[L + k], w2Im = wIm[L + k];
+                    for (int j = 0; j < count; j++) {
+                        double a0Re = xRe[j], a0Im = xIm[j];
+                        double a1Re = xRe[j + stride] * w1Re - xIm[j + stride] * w1Im;
+                        double a1Im = xRe[j + stride] * w1Im + xIm[j + stride] * w1Re;
+                        double a2Re = xRe[j + 2 * stride] * w2Re - xIm[j + 2 * stride] * w2Im;
+                        double a2Im = xRe[j + 2 * stride] * w2Im + xIm[j + 2 * stride] * w2Re;
+
+                        double sRe = a1Re + a2Re, sIm = a1Im + a2Im;
+                        double mRe = a0Re - 0.5 * sRe, mIm = a0Im - 0.5 * sIm;
+                        double dRe = s60 * (a1Re - a2Re), dIm = s60 * (a1Im - a2Im);
+
+                        // y1 = m - i d, y2 = m + i d
+                        xRe[j] = a0Re + sRe;
+                        xIm[j] = a0Im + sIm;
+                        xRe[j + stride] = mRe + dIm;
+                        xIm[j + stride] = mIm - dRe;
+                        xRe[j + 2 * stride] = mRe - dIm;
+                        xIm[j + 2 * stride] = mIm + dRe;
+                    }
+                }
+                else {
+                    const double c1 = 0.30901699437494742410;  // cos(2 pi / 5)
+                    const double c2 = -0.80901699437494742410; // cos(4 pi / 5)
+                    const double s1 = 0.95105651629515357212;  // sin(2 pi / 5)
+                    const double s2 = 0.58778525229247312917;  // sin(4 pi / 5)
+                    const double w1Re = wRe[k], w1Im = wIm[k];
+                    const double w2Re = wRe[L + k], w2Im = wIm[L + k];
+                    const double w3Re = wRe[2 * L + k], w3Im = wIm[2 * L + k];
+                    const double w4Re = wRe[3 * L + k], w4Im = wIm[3 * L + k];
+                    for (int j = 0; j < count; j++) {
+                        double a0Re = xRe[j], a0Im = xIm[j];
+                        double a1Re = xRe[j + stride] * w1Re - xIm[j + stride] * w1Im;
+                        double a1Im = xRe[j + stride] * w1Im + xIm[j + stride] * w1Re;
+                        double a2Re = xRe[j + 2 * stride] * w2Re - xIm[j + 2 * stride] * w2Im;
+                        double a2Im = xRe[j + 2 * stride] * w2Im + xIm[j + 2 * stride] * w2Re;
+                        double a3Re = xRe[j + 3 * stride] * w3Re - xIm[j + 3 * stride] * w3Im;
+                        double a3Im = xRe[j + 3 * stride] * w3Im + xIm[j + 3 * stride] * w3Re;
+                        double a4Re = xRe[j + 4 * stride] * w4Re - xIm[j + 4 * stride] * w4Im;
+                        double a4Im = xRe[j + 4 * stride] * w4Im + xIm[j + 4 * stride] * w4Re;
+
+                        double t1Re = a1Re + a4Re, t1Im = a1Im + a4Im;
+                        double t2Re = a2Re + a3Re, t2Im = a2Im + a3Im;
+                        double t3Re = a1Re - a4Re, t3Im = a1Im - a4Im;
+                        double t4Re = a2Re - a3Re, t4Im = a2Im - a3Im;
+
+                        double b1Re = a0Re + c1 * t1Re + c2 * t2Re;
+                        double b1Im = a0Im + c1 * t1Im + c2 * t2Im;
+                        double b2Re = a0Re + c2 * t1Re + c1 * t2Re;
+                        double b2Im = a0Im + c2 * t1Im + c1 * t2Im;
+                        double e1Re = s1 * t3Re + s2 * t4Re;
+                        double e1Im = s1 * t3Im + s2 * t4Im;
+                        double e2Re = s2 * t3Re - s1 * t4Re;
+                        double e2Im = s2 * t3Im - s1 * t4Im;
+
+                        // y1 = b1 - i e1, y4 = b1 + i e1, y2 = b2 - i e2, y3 = b2 + i e2
+                        xRe[j] = a0Re + t1Re + t2Re;
+                        xIm[j] = a0Im + t1Im + t2Im;
+                        xRe[j + stride] = b1Re + e1Im;
+                        xIm[j + stride] = b1Im - e1Re;
+                        xRe[j + 4 * stride] = b1Re - e1Im;
+                        xIm[j + 4 * stride] = b1Im + e1Re;
+                        xRe[j + 2 * stride] = b2Re + e2Im;
+                        xIm[j + 2 * stride] = b2Im - e2Re;
+                        xRe[j + 3 * stride] = b2Re - e2Im;
+                        xIm[j + 3 * stride] = b2Im + e2Re;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void rfft_batch(const fft_plan * plan, const int count, const double x[], double re[], double im[])
+{
+    const int n = plan->half;
+
+    if (n == 0) {
+        for (int j = 0; j < count; j++) {
+            re[j] = x[j];
+            im[j] = 0;
+        }
+        return;
+    }
+
+    // pack even samples as real and odd samples as imaginary part, in
+    // digit-reversed order
+    for (int k = 0; k < n; k++) {
+        const double * xEven = x + 2 * plan->perm[k] * count;
+        const double * xOdd = xEven + count;
+        for (int j = 0; j < count; j++) {
+            re[k * count + j] = xEven[j];
+            im[k * count + j] = xOdd[j];
+        }
+    }
+    fft_stages(plan, count, re, im);
+
+    // split into the spectra of the even and odd samples and recombine
+    for (int j = 0; j < count; j++) {
+        double z0Re = re[j], z0Im = im[j];
+        re[j] = z0Re + z0Im;
+        im[j] = 0;
+        re[n * count + j] = z0Re - z0Im;
+        im[n * count + j] = 0;
+    }
+
+    for (int k = 1; k <= n / 2; k++) {
+        const double wRe = plan->splitRe[k], wIm = plan->splitIm[k];
+        double * aRePtr = re + k * count, * aImPtr = im + k * count;
+        double * bRePtr = re + (n - k) * count, * bImPtr = im + (n - k) * count;
+        for (int j = 0; j < count; j++) {
+            double aRe = aRePtr[j], aIm = aImPtr[j];
+            double bRe = bRePtr[j], bIm = bImPtr[j];
 
-    for (int i = 0; i < size; i++) {
-        // cplx tmp = { 0, -PI * i / size };
-        #if defined(__GNUC__) || defined(__GNUG__)
-	    cplx tmp = 0.0  - PI * i / size * I;
-        #elif defined(_MSC_VER)
-	    cplx tmp = {0.0, -PI * i / size };
-        #endif
-        a[i] = cexp(tmp);
-        //a[i] = cexp(-I * M_PI * i / size);
+            double eRe = 0.5 * (aRe + bRe);
+            double eIm = 0.5 * (aIm - bIm);
+            double oRe = 0.5 * (aIm + bIm);
+            double oIm = -0.5 * (aRe - bRe);
+
+            double tRe = oRe * wRe - oIm * wIm;
+            double tIm = oRe * wIm + oIm * wRe;
+
+            aRePtr[j] = eRe + tRe;
+            aImPtr[j] = eIm + tIm;
+            bRePtr[j] = eRe - tRe;
+            bImPtr[j] = -(eIm - tIm);
+        }
     }
 }
 
-static void _fft(cplx a[], cplx out[], int size, int step, cplx tw[])
-{   
-    if (step < size) {
-        _fft(out, a, size, step * 2, tw);
-        _fft(out + step, a + step, size, step * 2, tw);
+void irfft_batch(const fft_plan * plan, const int count, double re[], double im[], double x[])
+{
+    const int n = plan->half;
+
+    if (n == 0) {
+        for (int j = 0; j < count; j++) {
+            x[j] = re[j];
+        }
+        return;
+    }
+
+    // undo the split step to recover the half-length spectrum
+    for (int j = 0; j < count; j++) {
+        double x0 = re[j], xn = re[n * count + j];
+        re[j] = 0.5 * (x0 + xn);
+        im[j] = 0.5 * (x0 - xn);
+    }
+
+    for (int k = 1; k <= n / 2; k++) {
+        const double wRe = plan->splitRe[k], wIm = plan->splitIm[k];
+        double * aRePtr = re + k * count, * aImPtr = im + k * count;
+        double * bRePtr = re + (n - k) * count, * bImPtr = im + (n - k) * count;
+        for (int j = 0; j < count; j++) {
+            double aRe = aRePtr[j], aIm = aImPtr[j];
+            double bRe = bRePtr[j], bIm = -bImPtr[j];
+
+            double eRe = 0.5 * (aRe + bRe);
+            double eIm = 0.5 * (aIm + bIm);
+            double tRe = 0.5 * (aRe - bRe);
+            double tIm = 0.5 * (aIm - bIm);
 
-        for (int i = 0; i < size; i += 2 * step) {
-            //cplx t = tw[i] * out[i + step];
-            cplx t = _Cmulcc(tw[i], out[i + step]);
-            a[i / 2] = _Caddcc(out[i], t);
-            a[(i + size) / 2] = _Cminuscc(out[i], t);
+            // o = conj(w) * t
+            double oRe = tRe * wRe + tIm * wIm;
+            double oIm = tIm * wRe - tRe * wIm;
+
+            // z[k] = e + i o, z[n-k] = conj(e) + i conj(o)
+            aRePtr[j] = eRe - oIm;
+            aImPtr[j] = eIm + oRe;
+            bRePtr[j] = eRe + oIm;
+            bImPtr[j] = -eIm + oRe;
+        }
+    }
+
+    // inverse through conjugation, ifft(z) = conj(fft(conj(z))) / n, with
+    // x as scratch for the digit-reversal
+    double * sRe = x;
+    double * sIm = x + n * count;
+    for (int k = 0; k < n * count; k++) {
+        sRe[k] = re[k];
+        sIm[k] = -im[k];
+    }
+    for (int k = 0; k < n; k++) {
+        const int src = plan->perm[k] * count;
+        for (int j = 0; j < count; j++) {
+            re[k * count + j] = sRe[src + j];
+            im[k * count + j] = sIm[src + j];
         }
     }
+    fft_stages(plan, count, re, im);
+
+    for (int k = 0; k < n; k++) {
+        for (int j = 0; j < count; j++) {
+            x[2 * k * count + j] = re[k * count + j] / n;
+            x[(2 * k + 1) * count + j] = -im[k * count + j] / n;
+        }
+    }
+}
+
+void rfft(const fft_plan * plan, const double x[], double re[], double im[])
+{
+    rfft_batch(plan, 1, x, re, im);
 }
 
-void fft(cplx a[], int size, cplx tw[])
+void irfft(const fft_plan * plan, double re[], double im[], double x[])
 {
-    cplx * out = malloc(size * sizeof(cplx));
-    memcpy(out, a, size * sizeof(cplx));
-    _fft(a, out, size, 1, tw);
-    free(out);
+    irfft_batch(plan, 1, re, im, x);
 }
@@ -19,8 +19,59 @@ typedef _Dcomplex cplx;
 #ifndef CMPLX
 #define CMPLX(x, y) ((cplx)((double)(x) + _Complex_I * (double)(y)))
 #endif
-extern void twiddles(cplx a[], int size);
-// extern void _fft(cplx a[], cplx out[], int size, int step, cplx tw[]);
-extern void fft(cplx a[], int size, cplx tw[]);
-extern void ifft(cplx a[], int size, cplx tw[]);
+
+// largest number of radix stages a plan can hold
+#define FFT_MAX_STAGES 32
+
+// Precomputed tables for a real-input transform of length size. The real
+// transform is carried out as a complex transform of half the length on
+// the even/odd samples, followed by a split step. The half-length
+// transform is a mixed radix 2/3/4/5 decimation in time, so size has to be
+// 1 or twice a number of the form 2^a 3^b 5^c (see fft_next_size).
+// Complex data is kept in split layout (separate real and imaginary
+// arrays) so the butterflies vectorize.
+typedef struct fft_plan {
+    int size;           // real transform length
+    int half;           // length of the underlying complex transform
+    int * perm;         // digit-reversal permutation, half entries
+    int nStages;
+    int radix[FFT_MAX_STAGES];
+    int span[FFT_MAX_STAGES];     // sub-transform length entering the stage
+    int twOffset[FFT_MAX_STAGES];
+    double * twRe;      // butterfly twiddles, for stage s and leg q the
+    double * twIm;      // span[s] entries start at twOffset[s] + (q-1)*span[s]
+    double * splitRe;   // exp(-2 pi i k / size), k < half/2+1
+    double * splitIm;
+
+    int refs;           // users holding the plan through fft_plan_acquire
+    int cached;         // still referenced by the plan cache?
+    unsigned long lastUse;
+} fft_plan;
+
+// smallest valid transform length >= n
+extern int fft_next_size(const int n);
+
+extern fft_plan * fft_plan_create(const int size);
+extern void fft_plan_free(fft_plan * plan);
+
+// Shared plans from a small process-wide cache keyed by size. Plans are
+// read-only once built, so any number of threads may use the same plan.
+// Every fft_plan_acquire must be paired with fft_plan_release.
+extern fft_plan * fft_plan_acquire(const int size);
+extern void fft_plan_release(fft_plan * plan);
+// drop all cached plans not currently in use
+extern void fft_plan_cache_clear(void);
+
+// real-input forward transform: x has plan->size samples, re and im
+// receive bins 0..size/2 (both of length size/2+1)
+extern void rfft(const fft_plan * plan, const double x[], double re[], double im[]);
+// exact inverse of rfft; re and im are used as scratch and overwritten
+extern void irfft(const fft_plan * plan, double re[], double im[], double x[]);
+
+// The same transforms on count series of equal length at once, stored
+// interleaved (structure of arrays): sample i of series j is x[i * count + j],
+// bin k is re[k * count + j], im[k * count + j]. Butterflies run across the
+// series, and each series gives exactly the result of rfft / irfft.
+extern void rfft_batch(const fft_plan * plan, const int count, const double x[], double re[], double im[]);
+extern void irfft_batch(const fft_plan * plan, const int count, double re[], double im[], double x[]);
 #endif
@@ -16,22 +16,171 @@ typedef _Dcomplex cplx;
 #include <stdio.h>
 #include "stats.h"
 
-// compare function for qsort, for array of doubles
-static int compare (const void * a, const void * b)
+// Sorting and order statistics on doubles. Elements are compared with <
+// directly rather than through a qsort comparator; small ranges are
+// finished by insertion sort, and ranges whose partitioning degenerates
+// (recursion deeper than twice log2 of the length) fall back to heap sort,
+// so every routine stays O(n log n) at worst.
+#define SORT_SMALL 16
+
+static inline void swap_double(double * a, double * b)
 {
-    if (*(double*)a < *(double*)b) {
-        return -1;
-    } else if (*(double*)a > *(double*)b) {
-        return 1;
-    } else {
-        return 0;
+    double t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// y[lo..hi-1] in ascending order
+static void insertion_sort(double y[], const int lo, const int hi)
+{
+    for (int i = lo + 1; i < hi; i++) {
+        double x = y[i];
+        int j = i;
+        while (j > lo && x < y[j - 1]) {
+            y[j] = y[j - 1];
+            j--;
+        }
+        y[j] = x;
+    }
+}
+
+static void sift_down(double y[], const int lo, int root, const int n)
+{
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= n) {
+            return;
+        }
+        if (child + 1 < n && y[lo + child] < y[lo + child + 1]) {
+            child++;
+        }
+        if (!(y[lo + root] < y[lo + child])) {
+            return;
+        }
+        swap_double(&y[lo + root], &y[lo + child]);
+        root = child;
+    }
+}
+
+static void heap_sort(double y[], const int lo, const int hi)
+{
+    const int n = hi - lo;
+    for (int i = n / 2 - 1; i >= 0; i--) {
+        sift_down(y, lo, i, n);
+    }
+    for (int end = n - 1; end > 0; end--) {
+        swap_double(&y[lo], &y[lo + end]);
+        sift_down(y, lo, 0, end);
+    }
+}
+
+// Hoare partition of y[lo..hi-1] (at least 3 entries) around the median of
+// the first, middle and last entry. Returns p with y[lo..p] <= y[p+1..hi-1].
+static int partition(double y[], const int lo, const int hi)
+{
+    const int mid = lo + (hi - lo - 1) / 2;
+    if (y[mid] < y[lo]) {
+        swap_double(&y[mid], &y[lo]);
     }
+    if (y[hi - 1] < y[lo]) {
+        swap_double(&y[hi - 1], &y[lo]);
+    }
+    if (y[hi - 1] < y[mid]) {
+        swap_double(&y[hi - 1], &y[mid]);
+    }
+    const double pivot = y[mid];
+    
+    int i = lo - 1, j = hi;
+    for (;;) {
+        do {
+            i++;
+        } while (y[i] < pivot);
+        do {
+            j--;
+        } while (pivot < y[j]);
+        if (i >= j) {
+            return j;
+        }
+        swap_double(&y[i], &y[j]);
+    }
+}
+
+static int depth_limit(const int size)
+{
+    int depth = 0;
+    for (int n = size; n > 1; n >>= 1) {
+        depth += 2;
+    }
+    return depth;
+}
+
+static void introsort(double y[], int lo, int hi, int depth)
+{
+    while (hi - lo > SORT_SMALL) {
+        if (depth-- == 0) {
+            heap_sort(y, lo, hi);
+            return;
+        }
+        int p = partition(y, lo, hi);
+        // recurse into the smaller side, loop on the larger
+        if (p + 1 - lo < hi - p - 1) {
+            introsort(y, lo, p + 1, depth);
+            lo = p + 1;
+        } else {
+            introsort(y, p + 1, hi, depth);
+            hi = p + 1;
+        }
+    }
+    insertion_sort(y, lo, hi);
 }
 
-// wrapper for qsort for array of doubles. Sorts in-place
+// sorts in-place, ascending
 void sort(double y[], int size)
 {
-    qsort(y, size, sizeof(*y), compare);
+    introsort(y, 0, size, depth_limit(size));
+}
+
+// Places the order statistics ks[0] < ks[1] < ... (0-based ranks within
+// [lo, hi)) at their sorted positions. Each partition step sends every rank
+// to the side that holds it, so k ranks cost one pass per level over the
+// parts that still contain a rank.
+static void introselect(double y[], int lo, int hi, const int ks[], int nk, int depth)
+{
+    while (nk > 0 && hi - lo > SORT_SMALL) {
+        if (depth-- == 0) {
+            heap_sort(y, lo, hi);
+            return;
+        }
+        int p = partition(y, lo, hi);
+        int nLeft = 0;
+        while (nLeft < nk && ks[nLeft] <= p) {
+            nLeft++;
+        }
+        if (nLeft == nk) {
+            hi = p + 1;
+        } else if (nLeft == 0) {
+            lo = p + 1;
+        } else {
+            introselect(y, lo, p + 1, ks, nLeft, depth);
+            ks += nLeft;
+            nk -= nLeft;
+            lo = p + 1;
+        }
+    }
+    if (nk > 0) {
+        insertion_sort(y, lo, hi);
+    }
+}
+
+double order_statistic(double y[], const int size, const int k)
+{
+    introselect(y, 0, size, &k, 1, depth_limit(size));
+    return y[k];
+}
+
+void order_statistics(double y[], const int size, const int ks[], const int nk)
+{
+    introselect(y, 0, size, ks, nk, depth_limit(size));
 }
 
 // linearly spaced vector
@@ -45,40 +194,96 @@ void linspace(double start, double end, int num_groups, double out[])
     return;
 }
 
-double quantile(const double y[], const int size, const double quant)
-{   
-    double quant_idx, q, value;
+// quantile of an array that is already sorted in ascending order
+double quantile_sorted(const double sorted[], const int size, const double quant)
+{
+    double quant_idx, q;
     int idx_left, idx_right;
-    double * tmp = malloc(size * sizeof(*y));
-    memcpy(tmp, y, size * sizeof(*y));
-    sort(tmp, size);
-    
-    /*
-    for(int i=0; i < size; i++){
-        printf("y[%i]=%1.4f\n", i, y[i]);
-    }
-    for(int i=0; i < size; i++){
-        printf("sorted[%i]=%1.4f\n", i, tmp[i]);
-    }
-     */
     
     // out of range limit?
     q = 0.5 / size;
     if (quant < q) {
-        value = tmp[0]; // min value
-        free(tmp);
-        return value; 
+        return sorted[0]; // min value
     } else if (quant > (1 - q)) {
-        value = tmp[size - 1]; // max value
-        free(tmp);
-        return value; 
+        return sorted[size - 1]; // max value
     }
     
     quant_idx = size * quant - 0.5;
     idx_left = (int)floor(quant_idx);
     idx_right = (int)ceil(quant_idx);
-    value = tmp[idx_left] + (quant_idx - idx_left) * (tmp[idx_right] - tmp[idx_left]) / (idx_right - idx_left);
+    return sorted[idx_left] + (quant_idx - idx_left) * (sorted[idx_right] - sorted[idx_left]) / (idx_right - idx_left);
+}
+
+// the (at most two) ranks quantile_sorted reads for quant
+static int quantile_ranks(const int size, const double quant, int ranks[2])
+{
+    double q = 0.5 / size;
+    if (quant < q) {
+        ranks[0] = 0;
+        return 1;
+    } else if (quant > (1 - q)) {
+        ranks[0] = size - 1;
+        return 1;
+    }
+    double quant_idx = size * quant - 0.5;
+    ranks[0] = (int)floor(quant_idx);
+    ranks[1] = (int)ceil(quant_idx);
+    return ranks[1] == ranks[0] ? 1 : 2;
+}
+
+#define QUANTILES_STACK 16
+
+void quantiles(const double y[], const int size, const double quants[], const int n, double out[])
+{
+    if (n < 1) {
+        return;
+    }
+    if (size < 1) {
+        for (int i = 0; i < n; i++) {
+            out[i] = NAN;
+        }
+        return;
+    }
+    
+    // ranks needed by all quantiles, ascending and without repeats
+    int stackRanks[2 * QUANTILES_STACK] = {0};
+    int * ks = n <= QUANTILES_STACK ? stackRanks : malloc(2 * (size_t)n * sizeof(int));
+    int nk = 0;
+    for (int i = 0; i < n; i++) {
+        int ranks[2];
+        int nRanks = quantile_ranks(size, quants[i], ranks);
+        for (int r = 0; r < nRanks; r++) {
+            int j = nk;
+            while (j > 0 && ks[j - 1] > ranks[r]) {
+                j--;
+            }
+            if (j > 0 && ks[j - 1] == ranks[r]) {
+                continue;
+            }
+            memmove(ks + j + 1, ks + j, (nk - j) * sizeof(int));
+            ks[j] = ranks[r];
+            nk++;
+        }
+    }
+    
+    double * tmp = malloc(size * sizeof(*y));
+    memcpy(tmp, y, size * sizeof(*y));
+    order_statistics(tmp, size, ks, nk);
+    
+    // quantile_sorted only reads the ranks now in place
+    for (int i = 0; i < n; i++) {
+        out[i] = quantile_sorted(tmp, size, quants[i]);
+    }
     free(tmp);
+    if (ks != stackRanks) {
+        free(ks);
+    }
+}
+
+double quantile(const double y[], const int size, const double quant)
+{   
+    double value;
+    quantiles(y, size, &quant, 1, &value);
     return value;
 }
 
@@ -19,7 +19,15 @@ typedef _Dcomplex cplx;
 
 extern void linspace(double start, double end, int num_groups, double out[]);
 extern double quantile(const double y[], const int size, const double quant);
+extern double quantile_sorted(const double sorted[], const int size, const double quant);
+// quantile for n quantiles at once, from one multi-rank selection
+extern void quantiles(const double y[], const int size, const double quants[], const int n, double out[]);
 extern void sort(double y[], int size);
+// k-th smallest entry (0-based) in O(size); y is reordered so that y[k]
+// holds it, with no larger entry before and no smaller one after
+extern double order_statistic(double y[], const int size, const int k);
+// the same for nk ascending ranks ks at once
+extern void order_statistics(double y[], const int size, const int ks[], const int nk);
 extern void binarize(const double a[], const int size, int b[], const char how[]);
 extern double f_entropy(const double a[], const int size);
 extern void subset(const int a[], int b[], const int start, const int end);
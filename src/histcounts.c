@@ -12,6 +12,140 @@
 #include "stats.h"
 #include "histcounts.h"
 
+void histcounts_minmax(const double y[], const int size, double * minVal, double * maxVal)
+{
+    double lo = DBL_MAX, hi = -DBL_MAX;
+#ifdef _OPENMP
+#pragma omp simd reduction(min:lo) reduction(max:hi)
+#endif
+    for(int i = 0; i < size; i++)
+    {
+        lo = y[i] < lo ? y[i] : lo;
+        hi = y[i] > hi ? y[i] : hi;
+    }
+    *minVal = lo;
+    *maxVal = hi;
+}
+
+// count samples into nBins bins of width binStep starting at minVal; values
+// outside the range go to the first or last bin
+static void histcounts_uniform(const double y[], const int size, const double minVal, const double binStep,
+                               const int nBins, int binCounts[])
+{
+    for(int i = 0; i < nBins; i++)
+    {
+        binCounts[i] = 0;
+    }
+    for(int i = 0; i < size; i++)
+    {
+        int binInd = (y[i]-minVal)/binStep;
+        if(binInd < 0)
+            binInd = 0;
+        if(binInd >= nBins)
+            binInd = nBins-1;
+        binCounts[binInd] += 1;
+    }
+}
+
+#define HISTCOUNTS_MULTI_STACK 16
+
+// Counts for n bin counts nBins[k] over [minVal, maxVal], stored one after
+// the other in binCounts (nBins[0] entries, then nBins[1], ...). Bin widths
+// that differ by a power of two divide without rounding, so (y-minVal)/binStep
+// at a coarse resolution is exactly the fine quotient divided by 2^m, and a
+// coarse bin is the sum of 2^m adjacent fine bins. Only the finest member of
+// each such family is counted from the samples, all in the same pass; the
+// others are merged from it. The counts are those of histcounts_range;
+// entries with nBins[k] < 1 are skipped.
+void histcounts_multi(const double y[], const int size, const double minVal, const double maxVal,
+                      const int nBins[], const int n, int binCounts[])
+{
+    // per entry bookkeeping, on the stack for the usual handful of entries
+    int stackInts[4*HISTCOUNTS_MULTI_STACK];
+    double stackSteps[HISTCOUNTS_MULTI_STACK];
+    int * ints = n <= HISTCOUNTS_MULTI_STACK ? stackInts : malloc(4 * (size_t)n * sizeof(int));
+    double * binStep = n <= HISTCOUNTS_MULTI_STACK ? stackSteps : malloc((size_t)n * sizeof(double));
+    int * offset = ints;
+    int * source = ints + n;
+    int * shift = ints + 2*n;
+    int * direct = ints + 3*n;
+    
+    int total = 0;
+    int maxBins = 0;
+    for(int k = 0; k < n; k++)
+    {
+        offset[k] = total;
+        total += nBins[k];
+        if(nBins[k] > maxBins)
+            maxBins = nBins[k];
+    }
+    
+    // counted directly (source[k] == k) or merged from the finest entry with
+    // nBins[k] * 2^shift[k] bins
+    int nDirect = 0;
+    for(int k = 0; k < n; k++)
+    {
+        source[k] = k;
+        shift[k] = 0;
+        for(int m = 0; nBins[k] > 0 && ((long)nBins[k] << m) <= maxBins; m++)
+        {
+            for(int j = 0; j < n; j++)
+            {
+                if((j < k || m > 0) && nBins[j] == (nBins[k] << m))
+                {
+                    source[k] = j;
+                    shift[k] = m;
+                    break;
+                }
+            }
+        }
+        if(source[k] == k && nBins[k] > 0)
+            direct[nDirect++] = k;
+    }
+    
+    for(int d = 0; d < nDirect; d++)
+    {
+        const int k = direct[d];
+        binStep[k] = (maxVal - minVal)/nBins[k];
+        for(int b = 0; b < nBins[k]; b++)
+            binCounts[offset[k] + b] = 0;
+    }
+    
+    for(int i = 0; i < size; i++)
+    {
+        for(int d = 0; d < nDirect; d++)
+        {
+            const int k = direct[d];
+            int binInd = (y[i]-minVal)/binStep[k];
+            if(binInd < 0)
+                binInd = 0;
+            if(binInd >= nBins[k])
+                binInd = nBins[k]-1;
+            binCounts[offset[k] + binInd] += 1;
+        }
+    }
+    
+    for(int k = 0; k < n; k++)
+    {
+        if(source[k] == k)
+            continue;
+        const int * fine = binCounts + offset[source[k]];
+        const int width = 1 << shift[k];
+        for(int b = 0; b < nBins[k]; b++)
+        {
+            int count = 0;
+            for(int f = b*width; f < (b+1)*width; f++)
+                count += fine[f];
+            binCounts[offset[k] + b] = count;
+        }
+    }
+    
+    if(ints != stackInts)
+        free(ints);
+    if(binStep != stackSteps)
+        free(binStep);
+}
+
 int num_bins_auto(const double y[], const int size){
     
     double maxVal = max_(y, size);
@@ -28,83 +162,49 @@ int num_bins_auto(const double y[], const int size){
 int histcounts_preallocated(const double y[], const int size, int nBins, int * binCounts, double * binEdges)
 {
     
-    int i = 0;
-    
     // check min and max of input array
-    double minVal = DBL_MAX, maxVal=-DBL_MAX;
-    for(int i = 0; i < size; i++)
-    {
-        // printf("histcountInput %i: %1.3f\n", i, y[i]);
-        
-        if (y[i] < minVal)
-        {
-            minVal = y[i];
-        }
-        if (y[i] > maxVal)
-        {
-            maxVal = y[i];
-        }
-    }
+    double minVal, maxVal;
+    histcounts_minmax(y, size, &minVal, &maxVal);
     
     // and derive bin width from it
     double binStep = (maxVal - minVal)/nBins;
     
-    // variable to store counted occurances in
-    for(i = 0; i < nBins; i++)
-    {
-        binCounts[i] = 0;
-    }
+    // count occurances
+    histcounts_uniform(y, size, minVal, binStep, nBins, binCounts);
     
-    for(i = 0; i < size; i++)
+    for(int i = 0; i < nBins+1; i++)
     {
-        
-        int binInd = (y[i]-minVal)/binStep;
-        if(binInd < 0)
-            binInd = 0;
-        if(binInd >= nBins)
-            binInd = nBins-1;
-        //printf("histcounts, i=%i, binInd=%i, nBins=%i\n", i, binInd, nBins);
-        binCounts[binInd] += 1;
-        
+        binEdges[i] = i * binStep + minVal;
     }
     
-    for(i = 0; i < nBins+1; i++)
+    return 0;
+    
+}
+
+int histcounts_range(const double y[], const int size, const double minVal, const double maxVal, const int nBins, int * binCounts, double * binEdges)
+{
+    
+    // derive bin width from given range
+    double binStep = (maxVal - minVal)/nBins;
+    
+    // count occurances
+    histcounts_uniform(y, size, minVal, binStep, nBins, binCounts);
+    
+    for(int i = 0; i < nBins+1; i++)
     {
         binEdges[i] = i * binStep + minVal;
     }
     
-    /*
-     // debug
-     for(i=0;i<nBins;i++)
-     {
-     printf("%i: count %i, edge %1.3f\n", i, binCounts[i], binEdges[i]);
-     }
-     */
-    
-    return 0;
+    return nBins;
     
 }
 
 int histcounts(const double y[], const int size, int nBins, int ** binCounts, double ** binEdges)
 {
 
-    int i = 0;
-    
     // check min and max of input array
-    double minVal = DBL_MAX, maxVal=-DBL_MAX;
-    for(int i = 0; i < size; i++)
-    {
-        // printf("histcountInput %i: %1.3f\n", i, y[i]);
-        
-        if (y[i] < minVal)
-        {
-            minVal = y[i];
-        }
-        if (y[i] > maxVal)
-        {
-            maxVal = y[i];
-        }
-    }
+    double minVal, maxVal;
+    histcounts_minmax(y, size, &minVal, &maxVal);
     
     // if no number of bins given, choose spaces automatically
     if (nBins <= 0){
@@ -114,62 +214,99 @@ int histcounts(const double y[], const int size, int nBins, int ** binCounts, do
     // and derive bin width from it
     double binStep = (maxVal - minVal)/nBins;
     
-    // variable to store counted occurances in
+    // count occurances
     *binCounts = malloc(nBins * sizeof(int));
-    for(i = 0; i < nBins; i++)
-    {
-        (*binCounts)[i] = 0;
-    }
-    
-    for(i = 0; i < size; i++)
-    {
-        
-        int binInd = (y[i]-minVal)/binStep;
-        if(binInd < 0)
-            binInd = 0;
-        if(binInd >= nBins)
-            binInd = nBins-1;
-        (*binCounts)[binInd] += 1;
-        
-    }
+    histcounts_uniform(y, size, minVal, binStep, nBins, *binCounts);
     
     *binEdges = malloc((nBins+1) * sizeof(double));
-    for(i = 0; i < nBins+1; i++)
+    for(int i = 0; i < nBins+1; i++)
     {
         (*binEdges)[i] = i * binStep + minVal;
     }
-   
-    /*
-    // debug
-    for(i=0;i<nBins;i++)
-    {
-        printf("%i: count %i, edge %1.3f\n", i, binCounts[i], binEdges[i]);
-    }
-    */
     
     return nBins;
     
 }
 
-int * histbinassign(const double y[], const int size, const double binEdges[], const int nEdges)
+// Edge arrays handed to histbinassign and histcount_edges are evenly spaced
+// in practice, so a sample's edge index is guessed arithmetically from the
+// first edge and the mean spacing, then moved to the exact edge by comparing
+// against the edge array itself. The comparisons are the ones the linear
+// scans make, so the result is the same for any ascending edges; the guess
+// only decides how few of them are needed. Edges that are not ascending
+// fall back to the plain scan.
+static int edges_ascending(const double binEdges[], const int nEdges)
 {
+    for(int j = 1; j < nEdges; j++)
+    {
+        if(!(binEdges[j-1] <= binEdges[j]))
+            return 0;
+    }
+    return 1;
+}
+
+// guess of the number of edges <= x (or < x), for ascending edges and x in
+// [binEdges[0], binEdges[nEdges-1]]
+static int edge_guess(const double x, const double binEdges[], const int nEdges, const double invStep)
+{
+    double g = (x - binEdges[0]) * invStep;
+    if(!(g >= 0))
+        return 0;
+    if(g >= nEdges - 1)
+        return nEdges - 1;
+    return (int)g;
+}
+
+static double edge_inv_step(const double binEdges[], const int nEdges)
+{
+    double width = binEdges[nEdges-1] - binEdges[0];
+    return (nEdges > 1 && width > 0) ? (nEdges - 1) / width : 0.0;
+}
+
+void histbinassign_preallocated(const double y[], const int size, const double binEdges[], const int nEdges, int binIdentity[])
+{
+    if(nEdges <= 0 || !edges_ascending(binEdges, nEdges))
+    {
+        for(int i = 0; i < size; i++)
+        {
+            // if not in any bin -> 0
+            binIdentity[i] = 0;
+            
+            // go through bin edges
+            for(int j = 0; j < nEdges; j++){
+                if(y[i] < binEdges[j]){
+                    binIdentity[i] = j;
+                    break;
+                }
+            }
+        }
+        return;
+    }
     
-    
-    // variable to store counted occurances in
-    int * binIdentity = malloc(size * sizeof(int));
+    const double invStep = edge_inv_step(binEdges, nEdges);
     for(int i = 0; i < size; i++)
     {
-        // if not in any bin -> 0
-        binIdentity[i] = 0;
-        
-        // go through bin edges
-        for(int j = 0; j < nEdges; j++){
-            if(y[i] < binEdges[j]){
-                binIdentity[i] = j;
-                break;
-            }
+        // first edge above the sample; none (or NaN) -> 0
+        if(!(y[i] < binEdges[nEdges-1]) || y[i] < binEdges[0])
+        {
+            binIdentity[i] = 0;
+            continue;
         }
+        int j = edge_guess(y[i], binEdges, nEdges, invStep) + 1;
+        while(j > 1 && y[i] < binEdges[j-1])
+            j--;
+        while(!(y[i] < binEdges[j]))
+            j++;
+        binIdentity[i] = j;
     }
+}
+
+int * histbinassign(const double y[], const int size, const double binEdges[], const int nEdges)
+{
+    
+    // variable to store counted occurances in
+    int * binIdentity = malloc(size * sizeof(int));
+    histbinassign_preallocated(y, size, binEdges, nEdges, binIdentity);
     
     return binIdentity;
     
@@ -184,17 +321,56 @@ int * histcount_edges(const double y[], const int size, const double binEdges[],
         histcounts[i] = 0;
     }
     
-    for(int i = 0; i < size; i++)
+    if(nEdges <= 0 || !edges_ascending(binEdges, nEdges))
     {
-        // go through bin edges
-        for(int j = 0; j < nEdges; j++){
-            if(y[i] <= binEdges[j]){
-                histcounts[j] += 1;
-                break;
+        for(int i = 0; i < size; i++)
+        {
+            // go through bin edges
+            for(int j = 0; j < nEdges; j++){
+                if(y[i] <= binEdges[j]){
+                    histcounts[j] += 1;
+                    break;
+                }
             }
         }
+        return histcounts;
+    }
+    
+    const double invStep = edge_inv_step(binEdges, nEdges);
+    for(int i = 0; i < size; i++)
+    {
+        // first edge at or above the sample; none (or NaN) -> not counted
+        if(!(y[i] <= binEdges[nEdges-1]))
+            continue;
+        int j = 0;
+        if(y[i] > binEdges[0])
+        {
+            j = edge_guess(y[i], binEdges, nEdges, invStep);
+            while(j > 0 && y[i] <= binEdges[j-1])
+                j--;
+            while(!(y[i] <= binEdges[j]))
+                j++;
+        }
+        histcounts[j] += 1;
     }
     
     return histcounts;
     
 }
+
+void histjointcounts(const int bins1[], const int bins2[], const int size, const int nEdges, int jointCounts[])
+{
+    const int nJoint = nEdges * nEdges;
+    for(int i = 0; i < nJoint; i++)
+    {
+        jointCounts[i] = 0;
+    }
+    for(int i = 0; i < size; i++)
+    {
+        int k = (bins1[i]-1)*nEdges + bins2[i] - 1;
+        if(k < 0)
+            k = 0;
+        if(k < nJoint)
+            jointCounts[k] += 1;
+    }
+}
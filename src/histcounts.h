@@ -15,8 +15,21 @@
 
 extern int num_bins_auto(const double y[], const int size);
 extern int histcounts(const double y[], const int size, int nBins, int ** binCounts, double ** binEdges);
+extern int histcounts_range(const double y[], const int size, const double minVal, const double maxVal, const int nBins, int * binCounts, double * binEdges);
+// histcounts_range for n bin counts at once, in a single pass over y;
+// binCounts receives nBins[0] counts, then nBins[1], ...
+extern void histcounts_multi(const double y[], const int size, const double minVal, const double maxVal, const int nBins[], const int n, int binCounts[]);
 extern int histcounts_preallocated(const double y[], const int size, int nBins, int * binCounts, double * binEdges);
 extern int * histcount_edges(const double y[], const int size, const double binEdges[], const int nEdges);
+// bin of each sample: the first j with y < binEdges[j], 0 if there is none
 extern int * histbinassign(const double y[], const int size, const double binEdges[], const int nEdges);
+extern void histbinassign_preallocated(const double y[], const int size, const double binEdges[], const int nEdges, int binIdentity[]);
+// minimum and maximum in one (vectorised) pass; NaN samples are ignored
+extern void histcounts_minmax(const double y[], const int size, double * minVal, double * maxVal);
+// Joint histogram of two histbinassign label arrays over nEdges edges. The
+// counts are laid out as histcount_edges would give them for the linear
+// labels (bins1-1)*nEdges + bins2 against the edges 1..nEdges^2: entry
+// (bins1-1)*nEdges + bins2-1, with labels below 1 counted in entry 0.
+extern void histjointcounts(const int bins1[], const int bins2[], const int size, const int nEdges, int jointCounts[]);
 
 #endif /* histcounts_h */
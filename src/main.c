@@ -31,6 +31,7 @@
 
 #include "stats.h"
 #include "helper_functions.h"
+#include "feature_context.h"
 
 // check if data qualifies to be caught22
 int quality_check(const double y[], const int size)
@@ -65,7 +66,8 @@ void run_features(double y[], int size, FILE * outfile)
         return;
     }
 
-    double * y_zscored = malloc(size * sizeof * y_zscored);
+    // intermediates shared by all features are computed once per series
+    feature_context ctx;
 
     // variables to keep time
     clock_t begin;
@@ -75,219 +77,215 @@ void run_features(double y[], int size, FILE * outfile)
     double result;
 
     // z-score first for all.
-    zscore_norm2(y, size, y_zscored);
+    context_init(&ctx, y, size, 1);
 
     // GOOD
     begin = clock();
-    result = DN_HistogramMode_5(y_zscored, size);
+    result = DN_HistogramMode_5_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "DN_HistogramMode_5", timeTaken);
 
     // GOOD
     begin = clock();
-    result = DN_HistogramMode_10(y_zscored, size);
+    result = DN_HistogramMode_10_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "DN_HistogramMode_10", timeTaken);
 
     //GOOD
     begin = clock();
-    result = CO_Embed2_Dist_tau_d_expfit_meandiff(y_zscored, size);
+    result = CO_Embed2_Dist_tau_d_expfit_meandiff_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "CO_Embed2_Dist_tau_d_expfit_meandiff", timeTaken);
 
     //GOOD (memory leak?)
     begin = clock();
-    result = CO_f1ecac(y_zscored, size);
+    result = CO_f1ecac_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "CO_f1ecac", timeTaken);
 
     //GOOD
     begin = clock();
-    result = CO_FirstMin_ac(y_zscored, size);
+    result = CO_FirstMin_ac_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "CO_FirstMin_ac", timeTaken);
 
     // GOOD (memory leak?)
     begin = clock();
-    result = CO_HistogramAMI_even_2_5(y_zscored, size);
+    result = CO_HistogramAMI_even_2_5_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "CO_HistogramAMI_even_2_5", timeTaken);
 
     // GOOD
     begin = clock();
-    result = CO_trev_1_num(y_zscored, size);
+    result = CO_trev_1_num_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "CO_trev_1_num", timeTaken);
 
-    // GOOD
-    begin = clock();
-    result = DN_OutlierInclude_p_001_mdrmd(y_zscored, size);
-    timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
-    fprintf(outfile, "%.14f, %s, %f\n", result, "DN_OutlierInclude_p_001_mdrmd", timeTaken);
-
-    // GOOD
+    // GOOD (p and n share one pass; the time is that of the pair)
+    double outlierInclude[2];
     begin = clock();
-    result = DN_OutlierInclude_n_001_mdrmd(y_zscored, size);
+    DN_OutlierInclude_pn_001_mdrmd_ctx(&ctx, outlierInclude);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
-    fprintf(outfile, "%.14f, %s, %f\n", result, "DN_OutlierInclude_n_001_mdrmd", timeTaken);
+    fprintf(outfile, "%.14f, %s, %f\n", outlierInclude[0], "DN_OutlierInclude_p_001_mdrmd", timeTaken);
+    fprintf(outfile, "%.14f, %s, %f\n", outlierInclude[1], "DN_OutlierInclude_n_001_mdrmd", timeTaken);
 
     //GOOD
     begin = clock();
-    result = FC_LocalSimple_mean1_tauresrat(y_zscored, size);
+    result = FC_LocalSimple_mean1_tauresrat_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "FC_LocalSimple_mean1_tauresrat", timeTaken);
 
     //GOOD
     begin = clock();
-    result = FC_LocalSimple_mean3_stderr(y_zscored, size);
+    result = FC_LocalSimple_mean3_stderr_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "FC_LocalSimple_mean3_stderr", timeTaken);
 
     //GOOD (memory leak?)
     begin = clock();
-    result = IN_AutoMutualInfoStats_40_gaussian_fmmi(y_zscored, size);
+    result = IN_AutoMutualInfoStats_40_gaussian_fmmi_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "IN_AutoMutualInfoStats_40_gaussian_fmmi", timeTaken);
 
     //GOOD
     begin = clock();
-    result = MD_hrv_classic_pnn40(y_zscored, size);
+    result = MD_hrv_classic_pnn40_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "MD_hrv_classic_pnn40", timeTaken);
 
     //GOOD
     begin = clock();
-    result = SB_BinaryStats_diff_longstretch0(y_zscored, size);
+    result = SB_BinaryStats_diff_longstretch0_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SB_BinaryStats_diff_longstretch0", timeTaken);
 
     //GOOD
     begin = clock();
-    result = SB_BinaryStats_mean_longstretch1(y_zscored, size);
+    result = SB_BinaryStats_mean_longstretch1_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SB_BinaryStats_mean_longstretch1", timeTaken);
 
     //GOOD (memory leak?)
     begin = clock();
-    result = SB_MotifThree_quantile_hh(y_zscored, size);
+    result = SB_MotifThree_quantile_hh_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SB_MotifThree_quantile_hh", timeTaken);
 
     //GOOD (memory leak?)
     begin = clock();
-    result = SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1(y_zscored, size);
+    result = SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SC_FluctAnal_2_rsrangefit_50_1_logi_prop_r1", timeTaken);
 
     //GOOD
     begin = clock();
-    result = SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1(y_zscored, size);
+    result = SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SC_FluctAnal_2_dfa_50_1_2_logi_prop_r1", timeTaken);
 
     //GOOD
     begin = clock();
-    result = SP_Summaries_welch_rect_area_5_1(y_zscored, size);
+    result = SP_Summaries_welch_rect_area_5_1_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SP_Summaries_welch_rect_area_5_1", timeTaken);
 
     //GOOD
     begin = clock();
-    result = SP_Summaries_welch_rect_centroid(y_zscored, size);
+    result = SP_Summaries_welch_rect_centroid_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SP_Summaries_welch_rect_centroid", timeTaken);
 
     //OK, BUT filt in Butterworth sometimes diverges, now removed alltogether, let's see results.
     begin = clock();
-    result = SB_TransitionMatrix_3ac_sumdiagcov(y_zscored, size);
+    result = SB_TransitionMatrix_3ac_sumdiagcov_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SB_TransitionMatrix_3ac_sumdiagcov", timeTaken);
 
     // GOOD
     begin = clock();
-    result = PD_PeriodicityWang_th0_01(y_zscored, size);
+    result = PD_PeriodicityWang_th0_01_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "PD_PeriodicityWang_th0_01", timeTaken);
 
     // catchaMouse16
 
     begin = clock();
-    result = SY_DriftingMean50_min(y_zscored, size);
+    result = SY_DriftingMean50_min_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SY_DriftingMean50_min", timeTaken);
 
     begin = clock();
-    result = CO_AddNoise_1_even_10_ami_at_10(y_zscored, size);
+    result = CO_AddNoise_1_even_10_ami_at_10_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "CO_AddNoise_1_even_10_ami_at_10", timeTaken);
 
     begin = clock();
-    result = AC_nl_036(y_zscored, size);
+    result = AC_nl_036_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "AC_nl_036", timeTaken);
 
     begin = clock();
-    result = AC_nl_035(y_zscored, size);
+    result = AC_nl_035_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "AC_nl_035", timeTaken);
 
     begin = clock();
-    result = AC_nl_112(y_zscored, size);
+    result = AC_nl_112_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "AC_nl_112", timeTaken);
 
     begin = clock();
-    result = IN_AutoMutualInfoStats_diff_20_gaussian_ami8(y_zscored, size);
+    result = IN_AutoMutualInfoStats_diff_20_gaussian_ami8_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "IN_AutoMutualInfoStats_diff_20_gaussian_ami8", timeTaken);
 
     begin = clock();
-    result = CO_HistogramAMI_even_10_3(y_zscored, size);
+    result = CO_HistogramAMI_even_10_3_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "CO_HistogramAMI_even_10_3", timeTaken);
 
     begin = clock();
-    result = CO_HistogramAMI_even_2_3(y_zscored, size);
+    result = CO_HistogramAMI_even_2_3_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "CO_HistogramAMI_even_2_3", timeTaken);
 
     begin = clock();
-    result = CO_TranslateShape_circle_35_pts_statav4_m(y_zscored, size);
+    result = CO_TranslateShape_circle_35_pts_statav4_m_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "CO_TranslateShape_circle_35_pts_statav4_m", timeTaken);
 
     begin = clock();
-    result = CO_TranslateShape_circle_35_pts_std(y_zscored, size);
+    result = CO_TranslateShape_circle_35_pts_std_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "CO_TranslateShape_circle_35_pts_std", timeTaken);
 
     begin = clock();
-    result = DN_RemovePoints_absclose_05_ac2rat(y_zscored, size);
+    result = DN_RemovePoints_absclose_05_ac2rat_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "DN_RemovePoints_absclose_05_ac2rat", timeTaken);
 
     begin = clock();
-    result = PH_Walker_momentum_5_w_momentumzcross(y_zscored, size);
+    result = PH_Walker_momentum_5_w_momentumzcross_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "PH_Walker_momentum_5_w_momentumzcross", timeTaken);
 
     begin = clock();
-    result = PH_Walker_biasprop_05_01_sw_meanabsdiff(y_zscored, size);
+    result = PH_Walker_biasprop_05_01_sw_meanabsdiff_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "PH_Walker_biasprop_05_01_sw_meanabsdiff", timeTaken);
 
     begin = clock();
-    result = SC_FluctAnal_2_dfa_50_2_logi_r2_se2(y_zscored, size);
+    result = SC_FluctAnal_2_dfa_50_2_logi_r2_se2_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SC_FluctAnal_2_dfa_50_2_logi_r2_se2", timeTaken);
 
     begin = clock();
-    result = ST_LocalExtrema_n100_diffmaxabsmin(y_zscored, size);
+    result = ST_LocalExtrema_n100_diffmaxabsmin_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "ST_LocalExtrema_n100_diffmaxabsmin", timeTaken);
 
     begin = clock();
-    result = SC_FluctAnal_2_dfa_50_2_logi_r2_se2(y_zscored, size);
+    result = SC_FluctAnal_2_dfa_50_2_logi_r2_se2_ctx(&ctx);
     timeTaken = (double)(clock()-begin)*1000/CLOCKS_PER_SEC;
     fprintf(outfile, "%.14f, %s, %f\n", result, "SC_FluctAnal_2_dfa_50_2_logi_r2_se2", timeTaken);
 
@@ -295,7 +293,7 @@ void run_features(double y[], int size, FILE * outfile)
 
     fprintf(outfile, "\n");
 
-    free(y_zscored);
+    context_free(&ctx);
 }
 
 void print_help(char *argv[], char msg[])
@@ -80,12 +80,13 @@ double median(const double a[], const int size)
     double m;
     double * b = malloc(size * sizeof *b);
     memcpy(b, a, size * sizeof *b);
-    sort(b, size);
     if (size % 2 == 1) {
-        m = b[size / 2];
+        m = order_statistic(b, size, size / 2);
     } else {
         int m1 = size / 2;
         int m2 = m1 - 1;
+        int ks[2] = {m2, m1};
+        order_statistics(b, size, ks, 2);
         m = (b[m1] + b[m2]) / (double)2.0;
     }
     free(b);